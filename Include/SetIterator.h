@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <iterator>
 
 #define STB typename SetIteratorBase<T, sizeT, T&, T*>
@@ -7,9 +8,12 @@
 
 namespace nmg
 {
-template <typename T> class Node;
+// marks an empty table slot, and an iterator that points past the collection.
+const size_t NPOS = static_cast<size_t>(-1);
 
-template <typename T> class OSet;
+template <typename T> struct EntryStore;
+
+template <typename T, typename Hash, typename KeyEqual, typename Policy, typename Allocator> class OSet;
 
 template <typename T, typename sizeT, typename refT, typename ptrT> class SetIteratorBase
 {
@@ -38,13 +42,18 @@ template <typename T, typename sizeT, typename refT, typename ptrT> class SetIte
     bool operator==(const self& other) const;
     bool operator!=(const self& other) const;
 
+    template <typename, typename, typename, typename, typename> friend class OSet;
+
   protected:
-    SetIteratorBase(Node<T>* node, bool isReverse);
+    SetIteratorBase(const EntryStore<T>* store, size_t pos, bool isReverse);
     SetIteratorBase(const self& other);
 
   private:
-    Node<T>* node;
+    const EntryStore<T>* store;
+    size_t pos;
     bool isReverse;
+
+    void advance(bool backwards);
 };
 
 template <typename T, typename sizeT> class SetIterator : public SetIteratorBase<T, sizeT, T&, T*>
@@ -57,11 +66,13 @@ template <typename T, typename sizeT> class SetIterator : public SetIteratorBase
     using pointer = STB::pointer;
     using reference = STB::reference;
 
-    friend class OSet<T>;
+    SetIterator(const SetIterator<T, sizeT>& other);
+    SetIterator& operator=(const SetIterator<T, sizeT>& other) = default;
+
+    template <typename, typename, typename, typename, typename> friend class OSet;
 
   private:
-    SetIterator(Node<T>* node, bool isReverse);
-    SetIterator(const SetIterator<T, sizeT>& other);
+    SetIterator(const EntryStore<T>* store, size_t pos, bool isReverse);
 };
 template <typename T, typename sizeT> class ConstSetIterator : public SetIteratorBase<T, sizeT, const T&, const T*>
 {
@@ -73,11 +84,13 @@ template <typename T, typename sizeT> class ConstSetIterator : public SetIterato
     using pointer = CSTB::pointer;
     using reference = CSTB::reference;
 
-    friend class OSet<T>;
+    ConstSetIterator(const ConstSetIterator<T, sizeT>& other);
+    ConstSetIterator& operator=(const ConstSetIterator<T, sizeT>& other) = default;
+
+    template <typename, typename, typename, typename, typename> friend class OSet;
 
   private:
-    ConstSetIterator(Node<T>* node, bool isReverse);
-    ConstSetIterator(const ConstSetIterator<T, sizeT>& other);
+    ConstSetIterator(const EntryStore<T>* store, size_t pos, bool isReverse);
 };
 } // namespace nmg
 
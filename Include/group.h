@@ -0,0 +1,182 @@
+/*
+    Control bytes for the OSet hash table. Every table slot has one byte
+    that is either empty, deleted, or holds seven bits of the hash of the
+    entry in that slot. Slots are probed a group at a time, comparing a
+    whole group of control bytes at once with SSE2 (or AVX2), so entries
+    are only looked at when their tag matches.
+*/
+
+#pragma once
+#ifndef GROUP_H
+#define GROUP_H
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "hash.h"
+
+namespace nmg
+{
+
+using ctrl_t = int8_t;
+using GroupMask = uint32_t;
+
+const ctrl_t CTRL_EMPTY = -128;
+const ctrl_t CTRL_DELETED = -2;
+
+/// @brief Seven bits of the hash, stored in the control byte of a full slot.
+inline ctrl_t hash_tag(hash_t hval)
+{
+    return static_cast<ctrl_t>(hval & 0x7F);
+}
+
+/// @brief The remaining bits of the hash, used to pick the first group to probe.
+inline hash_t hash_home(hash_t hval)
+{
+    return hval >> 7;
+}
+
+/// @brief Returns the index of the lowest set bit and clears it.
+inline int pop_match(GroupMask& mask)
+{
+    int bit = std::countr_zero(mask);
+    mask &= mask - 1;
+    return bit;
+}
+
+/// @brief A group of control bytes, matched all at once.
+struct Group
+{
+#if defined(__AVX2__)
+    static constexpr size_t WIDTH = 32;
+
+    explicit Group(const ctrl_t* pos)
+        : _ctrl(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos)))
+    {
+    }
+
+    GroupMask match(ctrl_t tag) const
+    {
+        return static_cast<GroupMask>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_ctrl, _mm256_set1_epi8(tag))));
+    }
+
+    GroupMask match_empty() const
+    {
+        return match(CTRL_EMPTY);
+    }
+
+    // empty and deleted are the only control bytes with the sign bit set.
+    GroupMask match_empty_or_deleted() const
+    {
+        return static_cast<GroupMask>(_mm256_movemask_epi8(_ctrl));
+    }
+
+  private:
+    __m256i _ctrl;
+#elif defined(__SSE2__)
+    static constexpr size_t WIDTH = 16;
+
+    explicit Group(const ctrl_t* pos)
+        : _ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)))
+    {
+    }
+
+    GroupMask match(ctrl_t tag) const
+    {
+        return static_cast<GroupMask>(_mm_movemask_epi8(_mm_cmpeq_epi8(_ctrl, _mm_set1_epi8(tag))));
+    }
+
+    GroupMask match_empty() const
+    {
+        return match(CTRL_EMPTY);
+    }
+
+    // empty and deleted are the only control bytes with the sign bit set.
+    GroupMask match_empty_or_deleted() const
+    {
+        return static_cast<GroupMask>(_mm_movemask_epi8(_ctrl));
+    }
+
+  private:
+    __m128i _ctrl;
+#else
+    static constexpr size_t WIDTH = 16;
+
+    explicit Group(const ctrl_t* pos)
+        : _ctrl(pos)
+    {
+    }
+
+    GroupMask match(ctrl_t tag) const
+    {
+        GroupMask mask = 0;
+        for (size_t i = 0; i < WIDTH; ++i)
+        {
+            mask |= static_cast<GroupMask>(_ctrl[i] == tag) << i;
+        }
+        return mask;
+    }
+
+    GroupMask match_empty() const
+    {
+        return match(CTRL_EMPTY);
+    }
+
+    GroupMask match_empty_or_deleted() const
+    {
+        GroupMask mask = 0;
+        for (size_t i = 0; i < WIDTH; ++i)
+        {
+            mask |= static_cast<GroupMask>(_ctrl[i] < 0) << i;
+        }
+        return mask;
+    }
+
+  private:
+    const ctrl_t* _ctrl;
+#endif
+};
+
+/// @brief Triangular probing over whole groups, which visits every group
+/// once when the number of groups is a power of two. Other group counts
+/// step linearly so every group is still visited. Stepping never divides.
+struct ProbeSeq
+{
+    /// @param home The first group to probe, from the reduction of the table.
+    /// @param groups The number of groups.
+    ProbeSeq(size_t home, size_t groups)
+        : _groups(groups), _group(home), _index(0), _triangular((_groups & (_groups - 1)) == 0)
+    {
+    }
+
+    /// @brief The first slot of the current group.
+    size_t offset() const
+    {
+        return _group * Group::WIDTH;
+    }
+
+    void next()
+    {
+        ++_index;
+        if (_triangular)
+        {
+            _group = (_group + _index) & (_groups - 1);
+        }
+        else if (++_group == _groups)
+        {
+            _group = 0;
+        }
+    }
+
+  private:
+    size_t _groups;
+    size_t _group;
+    size_t _index;
+    bool _triangular;
+};
+} // namespace nmg
+
+#endif
@@ -0,0 +1,188 @@
+/*
+    Hash and KeyEqual adapters for an OSet of key-value entries. Only the
+    key of an entry is hashed and compared, and both adapters are
+    transparent, so such a set is searched with a key on its own. They
+    tell entries from keys by the exact entry type, so a key may itself
+    be a pair. OMap and LruMap keep their entries in a KeyedSlot, and
+    hand them out through a MapIterator.
+*/
+
+#pragma once
+#ifndef KEYED_H
+#define KEYED_H
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "hash.h"
+
+namespace nmg
+{
+
+/// @brief The slot an OMap keeps an entry in. It is handed out as
+/// std::pair<const K, V>, and moved around the entry store as the
+/// std::pair<K, V> sharing its layout, so relocating an entry moves its
+/// key rather than copying it. Reading a union through another member
+/// than the one constructed is type punning GCC, Clang and MSVC support.
+template <typename K, typename V> union KeyedSlot
+{
+    static_assert(sizeof(std::pair<K, V>) == sizeof(std::pair<const K, V>) &&
+                      alignof(std::pair<K, V>) == alignof(std::pair<const K, V>),
+                  "pair<K, V> and pair<const K, V> must share a layout");
+
+    std::pair<const K, V> _value;
+    std::pair<K, V> _movable;
+
+    template <typename... Args>
+        requires std::is_constructible_v<std::pair<const K, V>, Args...>
+    explicit KeyedSlot(Args&&... args)
+        : _value(std::forward<Args>(args)...)
+    {
+    }
+
+    KeyedSlot(const KeyedSlot& other)
+        requires std::is_copy_constructible_v<std::pair<const K, V>>
+        : _value(other._value)
+    {
+    }
+
+    KeyedSlot(KeyedSlot&& other) noexcept(std::is_nothrow_move_constructible_v<std::pair<K, V>>)
+        : _value(std::piecewise_construct, std::forward_as_tuple(std::move(other._movable.first)),
+                 std::forward_as_tuple(std::move(other._movable.second)))
+    {
+    }
+
+    KeyedSlot& operator=(const KeyedSlot&) = delete;
+
+    ~KeyedSlot()
+    {
+        _value.~pair();
+    }
+};
+
+/// @brief Iterator over the entries of an OMap or LruMap, wrapping an
+/// iterator of its OSet of KeyedSlots.
+/// @tparam SetIt The OSet iterator type.
+/// @tparam Value std::pair<const K, V>, const for a const iterator.
+template <typename SetIt, typename Value> class MapIterator
+{
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::remove_const_t<Value>;
+    using pointer = Value*;
+    using reference = Value&;
+
+    explicit MapIterator(const SetIt& it)
+        : _it(it)
+    {
+    }
+
+    MapIterator& operator++()
+    {
+        ++_it;
+        return *this;
+    }
+
+    MapIterator operator++(int)
+    {
+        MapIterator old = *this;
+        ++_it;
+        return old;
+    }
+
+    MapIterator& operator--()
+    {
+        --_it;
+        return *this;
+    }
+
+    MapIterator operator--(int)
+    {
+        MapIterator old = *this;
+        --_it;
+        return old;
+    }
+
+    reference operator*() const
+    {
+        return *operator->();
+    }
+
+    pointer operator->() const
+    {
+        SetIt it = _it;
+        return &it->_value;
+    }
+
+    bool operator==(const MapIterator& other) const
+    {
+        return _it == other._it;
+    }
+
+    bool operator!=(const MapIterator& other) const
+    {
+        return _it != other._it;
+    }
+
+    /// @brief Gets the wrapped OSet iterator.
+    const SetIt& base() const
+    {
+        return _it;
+    }
+
+  private:
+    SetIt _it;
+};
+
+/// @brief The key of an entry.
+template <typename K, typename V> const K& entry_key(const KeyedSlot<K, V>& entry)
+{
+    return entry._value.first;
+}
+
+/// @brief Hashes the key of an Entry, or a key on its own, with Hash.
+template <typename Hash, typename Entry> struct pair_key_hash
+{
+    using is_transparent = void;
+
+    [[no_unique_address]] Hash _hash;
+
+    hash_t operator()(const Entry& entry) const
+    {
+        return _hash(entry_key(entry));
+    }
+
+    template <typename Key>
+        requires(!std::same_as<Key, Entry>)
+    hash_t operator()(const Key& key) const
+    {
+        return _hash(key);
+    }
+};
+
+/// @brief Compares the key of an Entry with another Entry, or a key on its
+/// own, with KeyEqual.
+template <typename KeyEqual, typename Entry> struct pair_key_equal
+{
+    using is_transparent = void;
+
+    [[no_unique_address]] KeyEqual _equal;
+
+    bool operator()(const Entry& entry, const Entry& other) const
+    {
+        return _equal(entry_key(entry), entry_key(other));
+    }
+
+    template <typename Key>
+        requires(!std::same_as<Key, Entry>)
+    bool operator()(const Entry& entry, const Key& key) const
+    {
+        return _equal(entry_key(entry), key);
+    }
+};
+} // namespace nmg
+
+#endif
@@ -0,0 +1,252 @@
+/*
+    Bounded least-recently-used caches built on OSet. The insertion
+    order of the set is the recency order: a hit moves its item to the
+    back, and an item added to a full cache evicts the front one. Items
+    live in the single entry store of the set, so there is no list node
+    or map node per item.
+
+    An add is a single lookup that finds the item or adds it, and only
+    then is the front item evicted, so a miss is hashed once. Evicting
+    takes O(1), as the set keeps track of where its front is.
+*/
+
+#pragma once
+#ifndef LRU_H
+#define LRU_H
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "keyed.h"
+#include "oset.h"
+
+namespace nmg
+{
+
+template <typename T, typename Hash = hasher<T>, typename KeyEqual = default_equal<T>,
+          typename Policy = DefaultPolicy, typename Allocator = std::allocator<T>>
+class LruSet
+{
+  public:
+    /********** ALIASES **********/
+
+    using Set_t = OSet<T, Hash, KeyEqual, Policy, Allocator>;
+    using const_iterator = typename Set_t::const_iterator;
+    using eviction_callback = std::function<void(const T&)>;
+
+    /********** CONSTRUCTORS **********/
+
+    /// @brief Constructs an empty cache.
+    /// @param capacity The most items the cache holds, at least one.
+    /// @param onEvict Called with each item evicted to make room, if set.
+    /// @param alloc The allocator to use.
+    explicit LruSet(size_t capacity, eviction_callback onEvict = eviction_callback(),
+                    const Allocator& alloc = Allocator());
+
+    /********** ITERATION **********/
+
+    /// @brief Create constant iterator to the least recently used item.
+    /// @return A const iterator to the beginning of the cache.
+    const_iterator begin() const;
+
+    /// @brief Create constant iterator to end.
+    /// @return A const iterator to the end of the cache.
+    const_iterator end() const;
+
+    /********** DATA **********/
+
+    /// @brief Gets the most items the cache holds.
+    /// @return The capacity.
+    size_t capacity() const;
+
+    /// @brief Gets the set the items are kept in, in recency order.
+    /// @return The underlying set.
+    const Set_t& set() const;
+
+    /// @brief Gets the number of items in the cache.
+    /// @return The size of the cache.
+    size_t size() const;
+
+    /// @brief Returns if the cache is empty.
+    /// @return True if the cache is empty, false otherwise.
+    bool empty() const;
+
+    /// @brief Gets the number of touches that found their item.
+    /// @return The hit count.
+    size_t hits() const;
+
+    /// @brief Gets the number of touches that did not find their item.
+    /// @return The miss count.
+    size_t misses() const;
+
+    /// @brief Sets the hit and miss counts back to zero.
+    void reset_stats();
+
+    /// @brief Returns if an item is cached, without counting a hit or miss
+    /// or making it more recent.
+    /// @param item The item to search for.
+    /// @return True if the item is cached, false otherwise.
+    bool contains(const T& item) const;
+
+    /********** MUTATION **********/
+
+    /// @brief Looks up an item, making it the most recently used on a hit.
+    /// @param item The item to search for.
+    /// @return True on a hit, false on a miss.
+    bool touch(const T& item);
+
+    /// @brief Looks up the item equal to a key, making it the most recently
+    /// used on a hit. Needs a transparent Hash and KeyEqual.
+    /// @param key The key to search for.
+    /// @return True on a hit, false on a miss.
+    template <typename K>
+        requires transparent_key<Hash, KeyEqual>
+    bool touch(const K& key);
+
+    /// @brief Adds an item as the most recently used, evicting the least
+    /// recently used item if the cache is full. An item already cached is
+    /// made the most recently used instead.
+    /// @param item The item to add.
+    /// @return True if the item was added, false if it was already cached.
+    bool add(const T& item);
+
+    /// @brief Adds an item as the most recently used, see add(const T&).
+    /// @param item The item to add.
+    /// @return True if the item was added, false if it was already cached.
+    bool add(T&& item);
+
+    /// @brief Removes an item, without calling the eviction callback.
+    /// @param item The item to remove.
+    /// @return True if the item was removed, false if it was not cached.
+    bool remove(const T& item);
+
+    /// @brief Removes all items, without calling the eviction callback.
+    void clear();
+
+  private:
+    Set_t _set;
+    size_t _capacity;
+    size_t _hits;
+    size_t _misses;
+    eviction_callback _onEvict;
+
+    template <typename U> bool insert(U&& item);
+    void evict();
+};
+
+template <typename K, typename V, typename Hash = hasher<K>, typename KeyEqual = default_equal<K>,
+          typename Policy = DefaultPolicy, typename Allocator = std::allocator<std::pair<const K, V>>>
+class LruMap
+{
+  public:
+    /********** ALIASES **********/
+
+    using value_type = std::pair<const K, V>;
+    using slot_type = KeyedSlot<K, V>;
+    using Set_t = OSet<slot_type, pair_key_hash<Hash, slot_type>, pair_key_equal<KeyEqual, slot_type>, Policy,
+                       typename std::allocator_traits<Allocator>::template rebind_alloc<slot_type>>;
+    using const_iterator = MapIterator<typename Set_t::const_iterator, const value_type>;
+    using eviction_callback = std::function<void(const K&, V&)>;
+
+    /********** CONSTRUCTORS **********/
+
+    /// @brief Constructs an empty cache.
+    /// @param capacity The most entries the cache holds, at least one.
+    /// @param onEvict Called with the key and value of each entry evicted to
+    /// make room, if set. The value may be moved from.
+    /// @param alloc The allocator to use.
+    explicit LruMap(size_t capacity, eviction_callback onEvict = eviction_callback(),
+                    const Allocator& alloc = Allocator());
+
+    /********** ITERATION **********/
+
+    /// @brief Create constant iterator to the least recently used entry.
+    /// @return A const iterator to the beginning of the cache.
+    const_iterator begin() const;
+
+    /// @brief Create constant iterator to end.
+    /// @return A const iterator to the end of the cache.
+    const_iterator end() const;
+
+    /********** DATA **********/
+
+    /// @brief Gets the most entries the cache holds.
+    /// @return The capacity.
+    size_t capacity() const;
+
+    /// @brief Gets the set the entries are kept in, in recency order.
+    /// @return The underlying set.
+    const Set_t& set() const;
+
+    /// @brief Gets the number of entries in the cache.
+    /// @return The size of the cache.
+    size_t size() const;
+
+    /// @brief Returns if the cache is empty.
+    /// @return True if the cache is empty, false otherwise.
+    bool empty() const;
+
+    /// @brief Gets the number of gets that found their entry.
+    /// @return The hit count.
+    size_t hits() const;
+
+    /// @brief Gets the number of gets that did not find their entry.
+    /// @return The miss count.
+    size_t misses() const;
+
+    /// @brief Sets the hit and miss counts back to zero.
+    void reset_stats();
+
+    /// @brief Returns if a key is cached, without counting a hit or miss or
+    /// making it more recent.
+    /// @param key The key to search for.
+    /// @return True if the key is cached, false otherwise.
+    bool contains(const K& key) const;
+
+    /********** MUTATION **********/
+
+    /// @brief Looks up the value of a key, making it the most recently used
+    /// on a hit.
+    /// @param key The key to search for.
+    /// @return A pointer to the value on a hit, valid until the cache is next
+    /// changed, or nullptr on a miss.
+    V* get(const K& key);
+
+    /// @brief Looks up the value of a key of another type, see get(const K&).
+    /// Needs a transparent Hash and KeyEqual.
+    /// @param key The key to search for.
+    /// @return A pointer to the value on a hit, or nullptr on a miss.
+    template <typename Key>
+        requires transparent_key<Hash, KeyEqual>
+    V* get(const Key& key);
+
+    /// @brief Sets the value of a key and makes it the most recently used,
+    /// evicting the least recently used entry if a new entry does not fit.
+    /// @param key The key to set.
+    /// @param value The value to set it to.
+    /// @return True if the entry was added, false if an existing one was assigned.
+    bool put(const K& key, V value);
+
+    /// @brief Removes an entry, without calling the eviction callback.
+    /// @param key The key of the entry to remove.
+    /// @return True if the entry was removed, false if it was not cached.
+    bool remove(const K& key);
+
+    /// @brief Removes all entries, without calling the eviction callback.
+    void clear();
+
+  private:
+    Set_t _set;
+    size_t _capacity;
+    size_t _hits;
+    size_t _misses;
+    eviction_callback _onEvict;
+
+    template <typename Key> V* lookup(const Key& key);
+    void evict();
+};
+} // namespace nmg
+
+#include "lru.inc"
+#endif
@@ -0,0 +1,63 @@
+/*
+    Cache-line aligned buffers for the OSet entry store and hash table,
+    so a group of control bytes or a run of entries never straddles more
+    cache lines than it has to. Buffers come from the set's allocator,
+    rebound to whole cache lines.
+*/
+
+#pragma once
+#ifndef MEMORY_H
+#define MEMORY_H
+#include <cstddef>
+#include <memory>
+
+namespace nmg
+{
+
+const size_t CACHE_LINE_SIZE = 64;
+
+struct alignas(CACHE_LINE_SIZE) CacheLine
+{
+    unsigned char _bytes[CACHE_LINE_SIZE];
+};
+
+template <typename Allocator>
+using line_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<CacheLine>;
+
+inline size_t lines_for(size_t bytes)
+{
+    return (bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE;
+}
+
+/// @brief Asks for the cache line holding an address to be loaded, without
+/// waiting for it. Does nothing on compilers without a prefetch builtin.
+inline void prefetch(const void* address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
+/// @brief Allocates uninitialised, cache-line aligned room for count objects.
+template <typename U, typename Allocator> U* allocate_aligned(const Allocator& alloc, size_t count)
+{
+    static_assert(alignof(U) <= CACHE_LINE_SIZE, "over-aligned types are not supported");
+
+    line_allocator<Allocator> lines(alloc);
+    CacheLine* buffer = std::allocator_traits<line_allocator<Allocator>>::allocate(lines, lines_for(count * sizeof(U)));
+    return reinterpret_cast<U*>(buffer);
+}
+
+/// @brief Frees a buffer from allocate_aligned. Objects in it must already
+/// be destroyed.
+template <typename U, typename Allocator> void deallocate_aligned(const Allocator& alloc, U* buffer, size_t count)
+{
+    line_allocator<Allocator> lines(alloc);
+    std::allocator_traits<line_allocator<Allocator>>::deallocate(lines, reinterpret_cast<CacheLine*>(buffer),
+                                                                 lines_for(count * sizeof(U)));
+}
+} // namespace nmg
+
+#endif
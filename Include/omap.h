@@ -0,0 +1,236 @@
+/*
+    An insertion ordered map, on the same engine as OSet. Each key-value
+    pair is one entry of an OSet that hashes and compares only the key
+    (see keyed.h), so a lookup is a single probe and a pair takes no
+    allocation of its own.
+
+    Entries are kept in a KeyedSlot (see keyed.h), handed out as
+    std::pair<const K, V> so the key cannot be changed through an
+    iterator, and moved around the entry store key and all.
+*/
+
+#pragma once
+#ifndef OMAP_H
+#define OMAP_H
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "keyed.h"
+#include "oset.h"
+
+namespace nmg
+{
+
+template <typename K, typename V, typename Hash = hasher<K>, typename KeyEqual = default_equal<K>,
+          typename Policy = DefaultPolicy, typename Allocator = std::allocator<std::pair<const K, V>>>
+class OMap
+{
+  public:
+    /********** ALIASES **********/
+
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+    using slot_type = KeyedSlot<K, V>;
+    using Set_t = OSet<slot_type, pair_key_hash<Hash, slot_type>, pair_key_equal<KeyEqual, slot_type>, Policy,
+                       typename std::allocator_traits<Allocator>::template rebind_alloc<slot_type>>;
+    using iterator = MapIterator<typename Set_t::iterator, value_type>;
+    using const_iterator = MapIterator<typename Set_t::const_iterator, const value_type>;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+
+    /********** CONSTRUCTORS **********/
+
+    /// @brief Default constructor.
+    OMap();
+
+    /// @brief Constructs with an allocator for the table and the entries.
+    /// @param alloc The allocator to use.
+    explicit OMap(const Allocator& alloc);
+
+    /// @brief Constructs with room for a number of entries.
+    /// @param capacity Entries to reserve room for.
+    /// @param alloc The allocator to use.
+    explicit OMap(size_t capacity, const Allocator& alloc = Allocator());
+
+    /// @brief Constructs from a list of entries, keeping the first of any
+    /// equal keys.
+    /// @param entries The entries to add.
+    /// @param alloc The allocator to use.
+    OMap(std::initializer_list<value_type> entries, const Allocator& alloc = Allocator());
+
+    /// @brief Gets the allocator of the collection.
+    /// @return A copy of the allocator.
+    Allocator get_allocator() const;
+
+    /********** ITERATION **********/
+
+    /// @brief Create iterator to beginning.
+    /// @return An iterator to the first entry added.
+    iterator begin();
+
+    /// @brief Create constant iterator to beginning.
+    /// @return A const iterator to the first entry added.
+    const_iterator begin() const;
+
+    /// @brief Create constant iterator to beginning.
+    /// @return A const iterator to the first entry added.
+    const_iterator cbegin() const;
+
+    /// @brief Create iterator to end.
+    /// @return An iterator to the end of the collection.
+    iterator end();
+
+    /// @brief Create constant iterator to end.
+    /// @return A const iterator to the end of the collection.
+    const_iterator end() const;
+
+    /// @brief Create constant iterator to end.
+    /// @return A const iterator to the end of the collection.
+    const_iterator cend() const;
+
+    /// @brief Create reverse iterator to the last entry.
+    /// @return A reverse iterator to the last entry added.
+    iterator rbegin();
+
+    /// @brief Create reverse iterator to beginning.
+    /// @return A reverse iterator to the beginning of the collection.
+    iterator rend();
+
+    /********** DATA **********/
+
+    /// @brief Gets the size of the collection.
+    /// @return The number of entries.
+    size_t size() const;
+
+    /// @brief Returns if the collection is empty.
+    /// @return True if the collection is empty, false otherwise.
+    bool empty() const;
+
+    /// @brief Returns if a key is in the collection.
+    /// @param key The key to search for.
+    /// @return True if the key is in the collection, false otherwise.
+    bool contains(const K& key) const;
+
+    /// @brief Returns if a key of another type is in the collection. Needs a
+    /// transparent Hash and KeyEqual.
+    /// @param key The key to search for.
+    /// @return True if the key is in the collection, false otherwise.
+    template <typename Key>
+        requires transparent_key<Hash, KeyEqual>
+    bool contains(const Key& key) const;
+
+    /// @brief Finds the entry of a key.
+    /// @param key The key to search for.
+    /// @return An iterator to the entry, or end() if there is none.
+    iterator find(const K& key);
+
+    /// @brief Finds the entry of a key.
+    /// @param key The key to search for.
+    /// @return A const iterator to the entry, or end() if there is none.
+    const_iterator find(const K& key) const;
+
+    /// @brief Finds the entry of a key of another type. Needs a transparent
+    /// Hash and KeyEqual.
+    /// @param key The key to search for.
+    /// @return An iterator to the entry, or end() if there is none.
+    template <typename Key>
+        requires transparent_key<Hash, KeyEqual>
+    iterator find(const Key& key);
+
+    /// @brief Gets the value of a key.
+    /// @param key The key to search for.
+    /// @return The value.
+    /// @throws std::out_of_range if the key is not in the collection.
+    V& at(const K& key);
+
+    /// @brief Gets the value of a key.
+    /// @param key The key to search for.
+    /// @return The value.
+    /// @throws std::out_of_range if the key is not in the collection.
+    const V& at(const K& key) const;
+
+    /// @brief Gets the value of a key, adding the key with a default value
+    /// if it is not in the collection.
+    /// @param key The key to search for.
+    /// @return The value.
+    V& operator[](const K& key);
+
+    /// @brief Gets the value of a key, moving the key in with a default
+    /// value if it is not in the collection.
+    /// @param key The key to search for.
+    /// @return The value.
+    V& operator[](K&& key);
+
+    /********** CAPACITY **********/
+
+    /// @brief Makes room for a number of entries without growing again.
+    /// @param count The number of entries to make room for.
+    void reserve(size_t count);
+
+    /********** MUTATION **********/
+
+    /// @brief Adds a key with a value constructed from args, only if the key
+    /// is not in the collection yet. Nothing is constructed otherwise.
+    /// @param key The key to add.
+    /// @param args Arguments to construct the value from.
+    /// @return An iterator to the entry of the key, and true if it was added.
+    template <typename... Args> std::pair<iterator, bool> try_emplace(const K& key, Args&&... args);
+
+    /// @brief Moves in a key with a value constructed from args, only if the
+    /// key is not in the collection yet. Nothing is moved otherwise.
+    /// @param key The key to add.
+    /// @param args Arguments to construct the value from.
+    /// @return An iterator to the entry of the key, and true if it was added.
+    template <typename... Args> std::pair<iterator, bool> try_emplace(K&& key, Args&&... args);
+
+    /// @brief Adds a key with a value, or assigns the value if the key is
+    /// already in the collection, keeping its place in the order.
+    /// @param key The key to set.
+    /// @param value The value to set it to.
+    /// @return An iterator to the entry of the key, and true if it was added.
+    template <typename M> std::pair<iterator, bool> insert_or_assign(const K& key, M&& value);
+
+    /// @brief Moves in a key with a value, see insert_or_assign(const K&, M&&).
+    /// @param key The key to set.
+    /// @param value The value to set it to.
+    /// @return An iterator to the entry of the key, and true if it was added.
+    template <typename M> std::pair<iterator, bool> insert_or_assign(K&& key, M&& value);
+
+    /// @brief Removes the entry of a key.
+    /// @param key The key to remove.
+    /// @return True if the entry was removed. False if there was none.
+    bool remove(const K& key);
+
+    /// @brief Removes the entry of a key of another type. Needs a
+    /// transparent Hash and KeyEqual.
+    /// @param key The key to remove.
+    /// @return True if the entry was removed. False if there was none.
+    template <typename Key>
+        requires transparent_key<Hash, KeyEqual>
+    bool remove(const Key& key);
+
+    /// @brief Removes the entry an iterator points at.
+    /// @param pos An iterator to the entry, not end().
+    /// @return An iterator to the entry after it.
+    iterator erase(iterator pos);
+
+    /// @brief Removes all entries and releases their memory.
+    void clear();
+
+  private:
+    Set_t _set;
+
+    template <typename Key, typename... Args> std::pair<iterator, bool> emplace_key(Key&& key, Args&&... args);
+};
+} // namespace nmg
+
+#include "omap.inc"
+#endif
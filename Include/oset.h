@@ -1,24 +1,88 @@
 /*
     An ordered set. Efficient insertion, retrieval, and removal,
     while maintaining insertion order.
+
+    Elements are stored contiguously in insertion order (compact-dict
+    layout). The hash table only holds positions into that entry array,
+    so iteration is a sequential sweep and adding an element never
+    allocates a node of its own. Each table slot also has a control byte
+    holding part of the hash (see group.h), so lookups only compare
+    entries whose tag matches.
+
+    With a rehash budget set, a growing table is rebuilt incrementally:
+    the old table is kept next to the new one, lookups check both, and
+    every add or remove moves a bounded number of old slots across. The
+    entry store grows the same way, into a bigger buffer at the same
+    positions, and under churn it is compacted in place a few entries per
+    add. Each add moves at least the budget, and enough that the work is
+    done before the room it started with runs out, so no single add
+    moves every item.
+
+    The table engine is picked by the policy: the grouped table of
+    table.h by default, or the Robin Hood table of robinhood.h.
+
+    With a small size set in the policy, a set that holds no more items
+    than that has no table at all, and is searched by scanning its entry
+    store. That many entries are kept inside the set object itself, so a
+    small set allocates nothing. The table is built, and the entries moved
+    to the heap, once the set outgrows the small size.
+
+    State that most sets never need, the old table and store of an
+    incremental rehash, the rank tree of index_of and nth, and tuning
+    changed from the policy, is allocated out of line on first use. A set
+    object is then just its table, its entry store and one pointer.
 */
 
 #pragma once
 #ifndef OSET_H
 #define OSET_H
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include "SetIterator.h"
+#include "group.h"
+#include "hash.h"
+#include "memory.h"
+#include "policy.h"
+#include "ranks.h"
 
 
 namespace nmg
 {
 
-const size_t DEFAULT_CAPACITY = 64;
-const int MAX_COLLISION_AMOUNT = 5;
+const size_t DEFAULT_ENTRY_CAPACITY = 8;
+// items hashed ahead of being added by add_range.
+const size_t RANGE_BATCH_SIZE = 32;
+// lookups in flight at once in contains_many.
+const size_t PREFETCH_BATCH_SIZE = 16;
 // forward declarations for friend operators
-template <typename T> class OSet;
-template <typename T> std::ostream& operator<<(std::ostream& out, const nmg::OSet<T>& oset);
+template <typename T, typename Hash = hasher<T>, typename KeyEqual = default_equal<T>, typename Policy = DefaultPolicy,
+          typename Allocator = std::allocator<T>>
+class OSet;
+template <typename T, typename Hash, typename KeyEqual, typename Policy, typename Allocator>
+std::ostream& operator<<(std::ostream& out, const nmg::OSet<T, Hash, KeyEqual, Policy, Allocator>& oset);
+template <typename T, typename Hash, typename KeyEqual, typename Policy, typename Allocator>
+OSet<T, Hash, KeyEqual, Policy, Allocator> set_union(const OSet<T, Hash, KeyEqual, Policy, Allocator>& left,
+                                                     const OSet<T, Hash, KeyEqual, Policy, Allocator>& right);
+template <typename T, typename Hash, typename KeyEqual, typename Policy, typename Allocator>
+OSet<T, Hash, KeyEqual, Policy, Allocator> set_intersection(const OSet<T, Hash, KeyEqual, Policy, Allocator>& left,
+                                                            const OSet<T, Hash, KeyEqual, Policy, Allocator>& right);
+template <typename T, typename Hash, typename KeyEqual, typename Policy, typename Allocator>
+OSet<T, Hash, KeyEqual, Policy, Allocator> set_difference(const OSet<T, Hash, KeyEqual, Policy, Allocator>& left,
+                                                          const OSet<T, Hash, KeyEqual, Policy, Allocator>& right);
+template <typename T, typename Hash, typename KeyEqual, typename Policy, typename Allocator>
+OSet<T, Hash, KeyEqual, Policy, Allocator>
+set_symmetric_difference(const OSet<T, Hash, KeyEqual, Policy, Allocator>& left,
+                         const OSet<T, Hash, KeyEqual, Policy, Allocator>& right);
 
 struct item_already_exists : public std::logic_error
 {
@@ -27,49 +91,312 @@ struct item_already_exists : public std::logic_error
     {
     }
 
+    item_already_exists(const std::string& message)
+        : std::logic_error(message)
+    {
+    }
+
     item_already_exists()
         : std::logic_error("item already exists")
     {
     }
 };
 
-template <typename T> struct Node
+/// @brief Whether entries keep the full hash of their item, so growing the
+/// table never hashes an item again and most mismatches are found without
+/// comparing items. Integral keys hash cheaply enough to opt out;
+/// specialize this for other cheap keys.
+template <typename T> struct cache_hash : std::bool_constant<!std::is_integral_v<T> && !std::is_enum_v<T>>
+{
+};
+
+/// @brief Whether destroying an item through Allocator runs no code, so
+/// dropping every item is O(1).
+template <typename T, typename Allocator>
+constexpr bool trivial_destroy =
+    std::is_trivially_destructible_v<T> && !requires(Allocator& alloc, T* item) { alloc.destroy(item); };
+
+// a polymorphic allocator only runs the destructor.
+template <typename T, typename U>
+constexpr bool trivial_destroy<T, std::pmr::polymorphic_allocator<U>> = std::is_trivially_destructible_v<T>;
+
+/// @brief An item of the entry store. The entry only holds room for the
+/// item: the set constructs and destroys it through its allocator, so an
+/// allocator-aware item is given the allocator of the set.
+template <typename T, bool Cached = cache_hash<T>::value> struct Entry
 {
-    T _data;
-    Node<T>* next;
-    Node<T>* prev;
+    static constexpr bool CACHED = true;
+
+    union
+    {
+        T _data;
+    };
+    hash_t _hash;
 
-    explicit Node(const T& item)
-        : next(nullptr), prev(nullptr), _data(item)
+    explicit Entry(hash_t hval)
+        : _hash(hval)
     {
     }
+
+    ~Entry()
+    {
+    }
+
+    /// @brief Gets the hash kept with the item, to carry it over when the
+    /// item is moved to another entry.
+    hash_t kept_hash() const
+    {
+        return _hash;
+    }
 };
 
-template <typename T> class OSet
+template <typename T> struct Entry<T, false>
+{
+    static constexpr bool CACHED = false;
+
+    union
+    {
+        T _data;
+    };
+
+    explicit Entry(hash_t)
+    {
+    }
+
+    ~Entry()
+    {
+    }
+
+    hash_t kept_hash() const
+    {
+        return 0;
+    }
+};
+
+/// @brief How far an incremental growth or compaction of an EntryStore
+/// has got.
+template <typename T> struct StoreMotion
+{
+    // while the store grows incrementally, the entries before _unmoved are
+    // still in _oldEntries, at the same positions.
+    Entry<T>* _oldEntries = nullptr;
+    size_t _oldCapacity = 0;
+    size_t _unmoved = 0;
+    // while the store is compacted incrementally, every position in
+    // [_gapBegin, _gapEnd) is dead, and the entries from _gapEnd on are
+    // still to be moved down.
+    bool _compacting = false;
+    size_t _gapBegin = 0;
+    size_t _gapEnd = 0;
+};
+
+/// @brief Insertion ordered entry array. Removed entries stay in place as
+/// dead slots until the array is compacted, so positions are stable
+/// between compactions. Dead slots in front of _head are headroom that
+/// items moved to the front are placed into.
+template <typename T> struct EntryStore
+{
+    Entry<T>* _entries;
+    bool* _alive;
+    size_t _used;
+    size_t _capacity;
+    size_t _dead;
+    // every position before _head is dead.
+    size_t _head = 0;
+    // the growth or compaction in progress, or null. It is kept out of line
+    // by the set, so a store that is never moved incrementally is smaller.
+    StoreMotion<T>* _motion = nullptr;
+
+    /// @brief Gets the entry at a position, from whichever buffer holds it.
+    Entry<T>& entry(size_t pos) const
+    {
+        return _motion != nullptr && pos < _motion->_unmoved ? _motion->_oldEntries[pos] : _entries[pos];
+    }
+
+    /// @brief Finds the first live position at or after pos.
+    /// @return The position, or NPOS if there is none.
+    size_t seek_forward(size_t pos) const;
+
+    /// @brief Finds the last live position at or before pos.
+    /// @return The position, or NPOS if there is none.
+    size_t seek_backward(size_t pos) const;
+};
+
+/// @brief Room for a number of entries inside the set object, which the
+/// entry store uses while it fits. The entries are constructed in place
+/// by the set, like those of a heap buffer.
+template <typename T, size_t Size> struct InlineEntries
+{
+    union
+    {
+        Entry<T> _entries[Size];
+    };
+    bool _alive[Size];
+
+    InlineEntries()
+    {
+    }
+
+    ~InlineEntries()
+    {
+    }
+};
+
+template <typename T> struct InlineEntries<T, 0>
+{
+};
+
+/// @brief Owns an item taken out of an OSet by extract, along with its
+/// hash, until it is inserted into another set. The item is moved, never
+/// copied, and a stateless Hash lets the set it goes into skip hashing it.
+template <typename T, typename Hash> class SetNode
+{
+  public:
+    /// @brief Constructs an empty node.
+    SetNode()
+        : _item(), _hash(0)
+    {
+    }
+
+    /// @brief Takes the item of another node, leaving it empty.
+    SetNode(SetNode&& other)
+        : _item(std::move(other._item)), _hash(other._hash)
+    {
+        other._item.reset();
+    }
+
+    /// @brief Takes the item of another node, leaving it empty.
+    SetNode& operator=(SetNode&& other)
+    {
+        if (this != &other)
+        {
+            _item = std::move(other._item);
+            _hash = other._hash;
+            other._item.reset();
+        }
+        return *this;
+    }
+
+    /// @brief Returns if the node holds no item.
+    /// @return True if the node is empty, false otherwise.
+    bool empty() const
+    {
+        return !_item.has_value();
+    }
+
+    explicit operator bool() const
+    {
+        return _item.has_value();
+    }
+
+    /// @brief Gets the item. Changing it changes its hash, so it must stay
+    /// equal to what it was.
+    /// @return The item, which must exist.
+    T& value()
+    {
+        return *_item;
+    }
+
+    /// @brief Gets the item.
+    /// @return The item, which must exist.
+    const T& value() const
+    {
+        return *_item;
+    }
+
+  private:
+    template <typename, typename, typename, typename, typename> friend class OSet;
+
+    std::optional<T> _item;
+    hash_t _hash;
+
+    template <typename U>
+    SetNode(hash_t hval, U&& item)
+        : _item(std::forward<U>(item)), _hash(hval)
+    {
+    }
+};
+
+template <typename T, typename Hash, typename KeyEqual, typename Policy, typename Allocator> class OSet
 {
   public:
     /********** ALIASES **********/
 
     using iterator = SetIterator<T, size_t>;
     using const_iterator = ConstSetIterator<T, size_t>;
-    using Node_t = Node<T>;
+    using Entry_t = Entry<T>;
+    using Store_t = EntryStore<T>;
+    using node_type = SetNode<T, Hash>;
+    using Table_t = typename Policy::template table_type<typename Policy::reduction, typename Policy::index_type>;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
 
     /********** CONSTRUCTORS **********/
 
     /// @brief Default constructor.
     OSet();
 
+    /// @brief Constructs with an allocator for the table and the items.
+    /// @param alloc The allocator to use.
+    explicit OSet(const Allocator& alloc);
+
+    /// @brief Constructs with room for a number of items.
+    /// @param capacity Items to reserve room for.
+    /// @param hash The hash function to use.
+    /// @param equal The equality comparison to use.
+    /// @param alloc The allocator to use.
+    explicit OSet(size_t capacity, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                  const Allocator& alloc = Allocator());
+
+    /// @brief Constructs with room for a number of items.
+    /// @param capacity Items to reserve room for.
+    /// @param alloc The allocator to use.
+    OSet(size_t capacity, const Allocator& alloc);
+
+    /// @brief Constructs from the items of a range, see add_range.
+    /// @param first The beginning of the range.
+    /// @param last The end of the range.
+    /// @param alloc The allocator to use.
+    template <std::input_iterator InputIt>
+    OSet(InputIt first, InputIt last, const Allocator& alloc = Allocator());
+
+    /// @brief Constructs from a list of items, see add_range.
+    /// @param items The items to add.
+    /// @param alloc The allocator to use.
+    OSet(std::initializer_list<T> items, const Allocator& alloc = Allocator());
+
     /// @brief Copy constructor.
     /// @param other Itibag data being copied to this itibag.
-    OSet(const OSet<T>& other);
+    OSet(const OSet& other);
 
-    /// @brief Move constructor.
+    /// @brief Copy constructor with an allocator.
+    /// @param other Itibag data being copied to this itibag.
+    /// @param alloc The allocator to use.
+    OSet(const OSet& other, const Allocator& alloc);
+
+    /// @brief Move constructor. Takes over the buffers of other, so it never
+    /// throws, and containers of sets move rather than copy them. Items
+    /// kept inside a small set are moved across one by one.
     /// @param other Itibag data to be moved to this itibag.
-    OSet(const OSet<T>&& other);
+    OSet(OSet&& other) noexcept(std::is_nothrow_move_constructible_v<Hash> &&
+                                std::is_nothrow_move_constructible_v<KeyEqual> && INLINE_NOTHROW);
 
     /// @brief Destructor.
     ~OSet();
 
+    /// @brief Gets the allocator of the collection.
+    /// @return A copy of the allocator.
+    Allocator get_allocator() const;
+
+    /// @brief Gets the hash function of the collection.
+    /// @return A copy of the hash function.
+    Hash hash_function() const;
+
+    /// @brief Gets the equality comparison of the collection.
+    /// @return A copy of the equality comparison.
+    KeyEqual key_eq() const;
+
     /********** ITERATION **********/
 
     /// @brief Create iterator to beginning.
@@ -114,11 +441,162 @@ template <typename T> class OSet
     /// @return True if the collection is empty, false otherwise.
     bool empty() const;
 
+    /// @brief Gets the most items the collection can hold, which the index
+    /// type of the policy limits.
+    /// @return The maximum size.
+    size_t max_size() const;
+
     /// @brief Returns if the item is in the collection.
     /// @param item The item to search for.
     /// @return True if the item is in the collection, false otherwise.
     bool contains(const T& item) const;
 
+    /// @brief Returns if an item equal to a key is in the collection,
+    /// without constructing an item. Needs a transparent Hash and KeyEqual.
+    /// @param key The key to search for.
+    /// @return True if the item is in the collection, false otherwise.
+    template <typename K>
+        requires transparent_key<Hash, KeyEqual>
+    bool contains(const K& key) const;
+
+    /// @brief Looks up many items at once. Lookups are done in batches:
+    /// every item of a batch is hashed and its table group prefetched, then
+    /// the entry of its first candidate slot is prefetched, and only then
+    /// are items compared, so the memory latency of a batch overlaps.
+    /// @param items The items to search for.
+    /// @param found Set to whether each item is in the collection. Must be
+    /// at least as long as items.
+    /// @return The number of items found.
+    size_t contains_many(std::span<const T> items, std::span<bool> found) const;
+
+    /// @brief Finds an item.
+    /// @param item The item to search for.
+    /// @return An iterator to the item, or end() if it is not in the collection.
+    iterator find(const T& item);
+
+    /// @brief Finds an item.
+    /// @param item The item to search for.
+    /// @return A const iterator to the item, or cend() if it is not in the collection.
+    const_iterator find(const T& item) const;
+
+    /// @brief Finds the item equal to a key, without constructing an item.
+    /// Needs a transparent Hash and KeyEqual.
+    /// @param key The key to search for.
+    /// @return An iterator to the item, or end() if it is not in the collection.
+    template <typename K>
+        requires transparent_key<Hash, KeyEqual>
+    iterator find(const K& key);
+
+    /// @brief Finds the item equal to a key, without constructing an item.
+    /// Needs a transparent Hash and KeyEqual.
+    /// @param key The key to search for.
+    /// @return A const iterator to the item, or cend() if it is not in the collection.
+    template <typename K>
+        requires transparent_key<Hash, KeyEqual>
+    const_iterator find(const K& key) const;
+
+    /// @brief Gets the place of an item in the order. O(1) while no items
+    /// have been removed since the store was last compacted, O(log n)
+    /// otherwise; the first call after a compaction builds the rank tree
+    /// in O(n), so concurrent calls on a shared set need a lock.
+    /// @param item The item to search for.
+    /// @return The number of items before it, or NPOS if it is not in the collection.
+    size_t index_of(const T& item) const;
+
+    /// @brief Gets the place in the order of the item equal to a key, see
+    /// index_of(const T&). Needs a transparent Hash and KeyEqual.
+    /// @param key The key to search for.
+    /// @return The number of items before it, or NPOS if it is not in the collection.
+    template <typename K>
+        requires transparent_key<Hash, KeyEqual>
+    size_t index_of(const K& key) const;
+
+    /// @brief Finds an item by its place in the order, in the time index_of
+    /// takes.
+    /// @param index The number of items before it.
+    /// @return An iterator to the item, or end() if index is not less than size().
+    iterator nth(size_t index);
+
+    /// @brief Finds an item by its place in the order, see nth(size_t).
+    /// @param index The number of items before it.
+    /// @return A const iterator to the item, or cend() if index is not less than size().
+    const_iterator nth(size_t index) const;
+
+    /********** CAPACITY **********/
+
+    /// @brief Gets the entry store the items are kept in, along with the
+    /// dead entries removals leave behind. For diagnostics and tests.
+    /// @return The entry store.
+    const Store_t& store() const;
+
+    /// @brief Gets the number of slots in the hash table.
+    /// @return The table capacity, zero while a small set has no table.
+    size_t capacity() const;
+
+    /// @brief Gets the fraction of table slots holding an item.
+    /// @return The current load factor.
+    float load_factor() const;
+
+    /// @brief Gets the load factor at which the table grows.
+    /// @return The maximum load factor.
+    float max_load_factor() const;
+
+    /// @brief Sets the load factor at which the table grows.
+    /// @param factor A value in (0, 1].
+    void max_load_factor(float factor);
+
+    /// @brief Gets the factor the table capacity is multiplied by on growth.
+    /// @return The growth factor.
+    float growth_factor() const;
+
+    /// @brief Sets the factor the table capacity is multiplied by on growth.
+    /// @param factor A value greater than 1.
+    void growth_factor(float factor);
+
+    /// @brief Gets the smallest table capacity that will be allocated.
+    /// @return The minimum capacity.
+    size_t min_capacity() const;
+
+    /// @brief Sets the smallest table capacity that will be allocated.
+    /// @param capacity The minimum capacity.
+    void min_capacity(size_t capacity);
+
+    /// @brief Makes room for a number of items without growing again.
+    /// @param count The number of items to make room for.
+    void reserve(size_t count);
+
+    /// @brief Rebuilds the table with at least a number of slots, and at
+    /// least enough for the current items. Drops removed entries.
+    /// @param capacity The minimum number of table slots.
+    void rehash(size_t capacity);
+
+    /// @brief Releases all memory not needed by the current items, including
+    /// the table once the set is back within the small size.
+    void shrink_to_fit();
+
+    /// @brief Gets the least number of old slots moved per add or remove,
+    /// and of store entries moved per add, while the table is rehashed or
+    /// the store grown or compacted incrementally.
+    /// @return The rehash budget, zero if all of it happens in one go.
+    size_t rehash_budget() const;
+
+    /// @brief Sets the least number of old slots moved per add or remove,
+    /// and of store entries moved per add, while the table is rehashed or
+    /// the store grown or compacted incrementally.
+    /// @param budget The rehash budget, zero to do all of it in one go.
+    void rehash_budget(size_t budget);
+
+    /// @brief Returns if an incremental rehash is in progress.
+    /// @return True if an old table is still being moved across.
+    bool rehashing() const;
+
+    /// @brief Moves part of an incremental rehash, store growth or store
+    /// compaction along, e.g. when idle. Like an add, it may move items
+    /// within the store, so iterators are invalidated.
+    /// @param budget The number of old slots, and of store positions, to move across.
+    /// @return True if any of them is still in progress afterwards.
+    bool rehash_step(size_t budget);
+
     /********** MUTATION **********/
 
     /// @brief Add an item to the itibag.
@@ -126,50 +604,359 @@ template <typename T> class OSet
     /// @return true for success, false for failure.
     bool add(const T& item);
 
+    /// @brief Add an item to the itibag, moving it in.
+    /// @param item Item to be added. Left untouched if it is already present.
+    /// @return true for success, false for failure.
+    bool add(T&& item);
+
+    /// @brief Constructs an item from args and adds it. The item is
+    /// constructed before the lookup, as it is needed to hash; an item
+    /// passed on its own is not constructed again.
+    /// @param args Arguments to construct the item from.
+    /// @return true for success, false if an equal item is already present.
+    template <typename... Args> bool emplace(Args&&... args);
+
+    /// @brief Finds the item equal to a key, or adds one constructed from
+    /// args when there is none, with a single lookup. The item constructed
+    /// must equal the key. The key is a T, or any key type with a
+    /// transparent Hash and KeyEqual.
+    /// @param key The key to search for.
+    /// @param args Arguments to construct the item from.
+    /// @return An iterator to the item found or added, and true if it was added.
+    template <typename K, typename... Args>
+        requires std::same_as<std::remove_cvref_t<K>, T> || transparent_key<Hash, KeyEqual>
+    std::pair<iterator, bool> find_or_emplace(const K& key, Args&&... args);
+
+    /// @brief Adds the items of a range, keeping the first of any equal
+    /// items. When the length of the range is known the table is sized for
+    /// it up front, and items are hashed a batch at a time before adding.
+    /// @param first The beginning of the range.
+    /// @param last The end of the range.
+    /// @return The number of items added.
+    template <std::input_iterator InputIt> size_t add_range(InputIt first, InputIt last);
+
+    /// @brief Adds an item constructed from a key and args, only after the
+    /// lookup for the key misses. The key is a T, or any key type with a
+    /// transparent Hash and KeyEqual.
+    /// @param key The key to search for, passed first to the constructor.
+    /// @param args Further arguments to construct the item from.
+    /// @return true for success, false if an equal item is already present.
+    template <typename K, typename... Args>
+        requires std::same_as<std::remove_cvref_t<K>, T> || transparent_key<Hash, KeyEqual>
+    bool try_emplace(K&& key, Args&&... args);
+
     /// @brief Remove an item from the itibag.
     /// @param item Item to be removed.
     /// @return True if the item was removed. False if it was not.
     bool remove(const T& item);
 
-    /// @brief Removes all items from the itibag.
+    /// @brief Removes the item equal to a key, without constructing an
+    /// item. Needs a transparent Hash and KeyEqual.
+    /// @param key The key of the item to be removed.
+    /// @return True if the item was removed. False if it was not.
+    template <typename K>
+        requires transparent_key<Hash, KeyEqual>
+    bool remove(const K& key);
+
+    /// @brief Removes the item an iterator points at. The table slot is
+    /// found by position, using the cached hash where there is one, so the
+    /// item is neither hashed nor compared.
+    /// @param pos An iterator to the item, not end().
+    /// @return An iterator to the item after it, in the direction of pos.
+    iterator erase(iterator pos);
+
+    /// @brief Removes the item an iterator points at, see erase(iterator).
+    /// @param pos An iterator to the item, not cend().
+    /// @return An iterator to the item after it, in the direction of pos.
+    iterator erase(const_iterator pos);
+
+    /// @brief Removes the items in a range.
+    /// @param first An iterator to the first item to remove.
+    /// @param last An iterator past the last item to remove.
+    /// @return An iterator to last.
+    iterator erase(iterator first, iterator last);
+
+    /// @brief Removes the items in a range.
+    /// @param first An iterator to the first item to remove.
+    /// @param last An iterator past the last item to remove.
+    /// @return An iterator to last.
+    iterator erase(const_iterator first, const_iterator last);
+
+    /// @brief Moves an item to the back of the order, as if it was just
+    /// added. The entry is moved within the store and its table slot
+    /// updated in place, so nothing is allocated, copied or probed for
+    /// beyond the lookup, apart from amortized store growth.
+    /// @param item The item to move.
+    /// @return True if the item was moved, false if it is not in the collection.
+    bool move_to_back(const T& item);
+
+    /// @brief Moves the item equal to a key to the back of the order, see
+    /// move_to_back(const T&). Needs a transparent Hash and KeyEqual.
+    /// @param key The key of the item to move.
+    /// @return True if the item was moved, false if it is not in the collection.
+    template <typename K>
+        requires transparent_key<Hash, KeyEqual>
+    bool move_to_back(const K& key);
+
+    /// @brief Moves the item an iterator points at to the back of the order.
+    /// @param pos An iterator to the item, not end().
+    /// @return An iterator to the item in its new place.
+    iterator move_to_back(iterator pos);
+
+    /// @brief Moves an item to the front of the order. Items are placed in
+    /// headroom kept in front of the store, which is made, in amortized
+    /// constant time, when it runs out.
+    /// @param item The item to move.
+    /// @return True if the item was moved, false if it is not in the collection.
+    bool move_to_front(const T& item);
+
+    /// @brief Moves the item equal to a key to the front of the order, see
+    /// move_to_front(const T&). Needs a transparent Hash and KeyEqual.
+    /// @param key The key of the item to move.
+    /// @return True if the item was moved, false if it is not in the collection.
+    template <typename K>
+        requires transparent_key<Hash, KeyEqual>
+    bool move_to_front(const K& key);
+
+    /// @brief Moves the item an iterator points at to the front of the order.
+    /// @param pos An iterator to the item, not end().
+    /// @return An iterator to the item in its new place.
+    iterator move_to_front(iterator pos);
+
+    /// @brief Takes an item out of the collection, moving it into a node.
+    /// @param item The item to take out.
+    /// @return A node holding the item, or an empty node if it is not in the collection.
+    node_type extract(const T& item);
+
+    /// @brief Takes the item equal to a key out of the collection, see
+    /// extract(const T&). Needs a transparent Hash and KeyEqual.
+    /// @param key The key of the item to take out.
+    /// @return A node holding the item, or an empty node if it is not in the collection.
+    template <typename K>
+        requires transparent_key<Hash, KeyEqual>
+    node_type extract(const K& key);
+
+    /// @brief Takes the item an iterator points at out of the collection.
+    /// @param pos An iterator to the item, not end().
+    /// @return A node holding the item.
+    node_type extract(iterator pos);
+
+    /// @brief Takes the item an iterator points at out of the collection.
+    /// @param pos An iterator to the item, not cend().
+    /// @return A node holding the item.
+    node_type extract(const_iterator pos);
+
+    /// @brief Adds the item of a node to the back of the order, moving it
+    /// in. With a stateless Hash the hash kept in the node is used.
+    /// @param node The node to take the item from. Left holding it if an
+    /// equal item is already present.
+    /// @return An iterator to the item found or added, and true if it was
+    /// added. end() and false for an empty node.
+    std::pair<iterator, bool> insert(node_type&& node);
+
+    /// @brief Moves the items of source that are not in this set to the
+    /// back of the order, keeping their order, and leaves the rest in
+    /// source. Room is made for all of source up front, and source is
+    /// rebuilt once at the end rather than per item taken.
+    /// @param source The set to take the items of.
+    void merge(OSet& source);
+
+    /// @brief Removes all items from the itibag and releases its memory.
     void clear();
 
+    /// @brief Removes all items from the itibag, keeping its capacity.
+    void reset();
+
+    /********** SET ALGEBRA **********/
+
+    // results keep the order of this set, then the order of other. Hashes
+    // cached in one set are reused to probe the other, with a stateless Hash.
+
+    /// @brief Adds the items of other that are not in this set.
+    /// @param other The set to add.
+    /// @return This itibag.
+    OSet& set_union(const OSet& other);
+
+    /// @brief Removes the items that are not in other. Probes whichever
+    /// set is larger with the items of the smaller.
+    /// @param other The set to intersect with.
+    /// @return This itibag.
+    OSet& set_intersection(const OSet& other);
+
+    /// @brief Removes the items that are in other. Probes whichever set is
+    /// larger with the items of the smaller.
+    /// @param other The set to subtract.
+    /// @return This itibag.
+    OSet& set_difference(const OSet& other);
+
+    /// @brief Removes the items that are in other, and adds the items of
+    /// other that were not in this set.
+    /// @param other The set to take the symmetric difference with.
+    /// @return This itibag.
+    OSet& set_symmetric_difference(const OSet& other);
+
+    /// @brief Makes a set of the items in either set, presized for both.
+    /// @return The union, in the order of left then right.
+    friend OSet nmg::set_union<>(const OSet& left, const OSet& right);
+
+    /// @brief Makes a set of the items in both sets, presized for the
+    /// smaller. Probes the larger set with the items of the smaller.
+    /// @return The intersection, in the order of left.
+    friend OSet nmg::set_intersection<>(const OSet& left, const OSet& right);
+
+    /// @brief Makes a set of the items of left that are not in right.
+    /// @return The difference, in the order of left.
+    friend OSet nmg::set_difference<>(const OSet& left, const OSet& right);
+
+    /// @brief Makes a set of the items in only one of the sets.
+    /// @return The symmetric difference, in the order of left then right.
+    friend OSet nmg::set_symmetric_difference<>(const OSet& left, const OSet& right);
+
     /********** OPERATORS **********/
 
     /// @brief copy-assignment operator.
     /// @param other Itibag to copy.
     /// @return This itibag.
-    OSet<T>& operator=(const OSet<T>& other);
+    OSet& operator=(const OSet& other);
 
-    /// @brief move-assignment operator.
+    /// @brief move-assignment operator. Takes over the buffers of other when
+    /// the allocator propagates or always compares equal, and never throws
+    /// then; otherwise unequal allocators move the items one by one. Items
+    /// kept inside a small set are always moved one by one.
     /// @param other Itibag to move.
     /// @return This itibag.
-    OSet<T>& operator=(const OSet<T>&& other);
+    OSet& operator=(OSet&& other) noexcept(MOVES_BUFFERS && std::is_nothrow_move_assignable_v<Hash> &&
+                                           std::is_nothrow_move_assignable_v<KeyEqual> && INLINE_NOTHROW);
 
     /// @brief Adds an item to the collection.
     /// @param item The item to add.
     /// @return This itibag.
-    OSet<T>& operator+=(const T& item);
+    OSet& operator+=(const T& item);
 
     /// @brief Inserts an oset into a stream.
     /// @param out The output stream to insert into.
     /// @param oset The oset to insert.
     /// @return The output stream.
-    friend std::ostream& operator<< <>(std::ostream& out, const OSet<T>& oset);
+    friend std::ostream& operator<< <>(std::ostream& out, const OSet& oset);
 
   private:
-    Node_t** _data;
-    size_t _size;
-    size_t _capacity;
-    Node_t* _head;
-    Node_t* _tail;
-
-    void copy_list(const Node_t* source);
-    void clear_list();
-    void resize_data();
-    bool findItem(int index, const T& item) const;
-    void remove_node(Node_t* node);
+    // whether move assignment can always take over the buffers of the other set.
+    static constexpr bool MOVES_BUFFERS =
+        std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value ||
+        std::allocator_traits<Allocator>::is_always_equal::value;
+    // entries kept inside the set, see InlineEntries.
+    static constexpr size_t INLINE_SIZE = Policy::small_size;
+    // whether items kept inside the set move across without throwing.
+    static constexpr bool INLINE_NOTHROW = INLINE_SIZE == 0 || std::is_nothrow_move_constructible_v<T>;
+    // whether entries can be moved around the store in place.
+    static constexpr bool RELOCATES_NOTHROW = std::is_nothrow_move_constructible_v<T>;
+
+    // state most sets never need, kept out of line so it takes no room in
+    // the set until it is first needed.
+    struct Extras
+    {
+        // the table being moved across during an incremental rehash. Slots
+        // before _migrated have been moved, and are no longer full.
+        Table_t _oldTable;
+        size_t _migrated = 0;
+        size_t _unmigrated = 0;
+        // the store growth or compaction in progress, see EntryStore::_motion.
+        StoreMotion<T> _motion;
+        // counts live entries before a position, while the store has dead ones.
+        RankTree _ranks;
+        // tuning, from the policy until it is changed.
+        float _maxLoadFactor = Policy::max_load_factor;
+        float _growthFactor = Policy::growth_factor;
+        size_t _minCapacity = Policy::min_capacity;
+        size_t _rehashBudget = Policy::rehash_budget;
+    };
+
+    Table_t _table;
+    Store_t _store;
+    [[no_unique_address]] InlineEntries<T, INLINE_SIZE> _inline;
+    // null until first needed; the const order queries build the rank tree
+    // in it.
+    mutable Extras* _extras;
+    [[no_unique_address]] Hash _hasher;
+    [[no_unique_address]] KeyEqual _equal;
+    [[no_unique_address]] Allocator _alloc;
+
+    Extras& extras() const;
+    void release_extras();
+    void copy_extras(const OSet& other);
+    RankTree* built_ranks() const;
+    void drop_ranks();
+    StoreMotion<T>& start_motion();
+    void end_motion();
+    bool stored_inline() const;
+    Store_t allocate_store(size_t capacity);
+    void release_entries(Entry_t* entries, size_t capacity);
+    void release_alive(bool* alive, size_t capacity);
+    void adopt_store(OSet& other);
+    void copy_store(const Store_t& source);
+    void move_store(Store_t& source);
+    template <typename Source, typename Item> void fill_store(Source& source, Item&& item);
+    void destroy_entries();
+    void copy_tables(const OSet& other);
+    void clear_store();
+    void clear_tables();
+    bool grow_store(size_t capacity, size_t headroom = 0);
+    size_t make_store_room(size_t pos = NPOS);
+    void start_store_growth();
+    bool grow_step(size_t budget);
+    void start_compaction();
+    bool compact_step(size_t budget);
+    void finish_compaction();
+    void advance_store();
+    size_t move_entry(size_t pos, bool toBack);
+    Table_t& table_of(size_t pos, hash_t hval, size_t& slot);
+    template <typename... Args> void construct_entry(Entry_t* entry, hash_t hval, Args&&... args);
+    void destroy_entry(Entry_t& entry);
+    void relocate_entry(Entry_t& from, Entry_t* to);
+    void trim_dead_tail();
+    void trim_dead_head();
+    size_t rank_of(size_t pos) const;
+    bool use_ranks() const;
+    void compact_store();
+    void make_room();
+    void reindex();
+    size_t max_load(size_t capacity) const;
+    size_t capacity_for(size_t count) const;
+    size_t round_capacity(size_t capacity) const;
+    void resize_data(size_t capacity);
+    void start_rehash(size_t capacity);
+    bool step_table(size_t budget);
+    size_t stride(size_t left, size_t room) const;
+    void finish_rehash();
+    template <typename K> size_t find_position(const K& key) const;
+    template <typename K> bool remove_key(const K& key);
+    template <typename K> size_t find_hashed(hash_t hval, const K& key) const;
+    template <typename K> bool remove_hashed(hash_t hval, const K& key);
+    hash_t shared_hash(const Entry_t& entry) const;
+    template <typename Keep> void append_if(const OSet& source, Keep&& keep);
+    template <typename K, typename... Args> bool insert_unique(const K& key, Args&&... args);
+    template <typename K, typename... Args>
+    std::pair<size_t, bool> insert_hashed(hash_t hval, const K& key, Args&&... args);
+    template <typename K> size_t findItem(const Table_t& table, hash_t hval, const K& key) const;
+    template <typename K> size_t scan_store(hash_t hval, const K& key) const;
+    hash_t entry_hash(const Entry_t& entry) const;
+    template <typename K> bool matches(const Entry_t& entry, hash_t hval, const K& key) const;
+    void remove_entry(Table_t& table, size_t slot);
+    void drop_entry(size_t pos);
+    void erase_position(size_t pos);
+    void unlink_position(size_t pos, hash_t hval);
+    node_type extract_position(size_t pos);
+    size_t erase_range(size_t first, size_t last, bool isReverse);
+    size_t next_position(size_t pos, bool isReverse) const;
 };
+
+namespace pmr
+{
+/// @brief An OSet that takes its memory from a std::pmr::memory_resource,
+/// e.g. a monotonic_buffer_resource for short-lived per-request sets.
+template <typename T, typename Hash = hasher<T>, typename KeyEqual = default_equal<T>, typename Policy = DefaultPolicy>
+using OSet = nmg::OSet<T, Hash, KeyEqual, Policy, std::pmr::polymorphic_allocator<T>>;
+} // namespace pmr
 }; // namespace nmg
 
 #include "oset.inc"
@@ -0,0 +1,59 @@
+/*
+    Policies for the OSet hash table. A policy is a struct of static
+    members; derive from DefaultPolicy and shadow the members you want
+    to change, then pass it as the Policy template parameter of OSet.
+*/
+
+#pragma once
+#ifndef POLICY_H
+#define POLICY_H
+#include <cstddef>
+#include <cstdint>
+
+#include "reduce.h"
+#include "robinhood.h"
+#include "table.h"
+
+namespace nmg
+{
+
+struct DefaultPolicy
+{
+    /// @brief Largest fraction of the table that may be in use, full or
+    /// deleted slots, before the table grows.
+    static constexpr float max_load_factor = 0.875f;
+
+    /// @brief Factor the table capacity is multiplied by when it grows.
+    static constexpr float growth_factor = 2.0f;
+
+    /// @brief Smallest table capacity that will be allocated.
+    static constexpr size_t min_capacity = 16;
+
+    /// @brief Least number of old table slots moved per add or remove, and
+    /// of store entries moved per add, while the table is rehashed or the
+    /// entry store grown or compacted incrementally. Zero does all of it in
+    /// one go.
+    static constexpr size_t rehash_budget = 0;
+
+    /// @brief Most items a set holds before it builds a table. Until then
+    /// lookups scan the entry store, which is kept inside the set object,
+    /// so a set that stays tiny allocates nothing. Zero builds the table on
+    /// the first add.
+    static constexpr size_t small_size = 0;
+
+    /// @brief How a hash is reduced to a table bucket, see reduce.h. Masking
+    /// keeps table sizes a power of two.
+    using reduction = MaskReduction;
+
+    /// @brief The type table slots store entry positions as. uint32_t or
+    /// uint16_t halve or quarter the slot memory, and cap the set at
+    /// max_size() items.
+    using index_type = size_t;
+
+    /// @brief The hash table engine: IndexTable probes a group of slots at
+    /// a time with SIMD, RobinHoodTable probes slots one by one.
+    template <typename Reduction, typename Index> using table_type = IndexTable<Reduction, Index>;
+};
+} // namespace nmg
+
+#endif
@@ -0,0 +1,145 @@
+/*
+    Order statistics for the OSet entry store. A Fenwick tree over the
+    live flags of the store counts the live entries before any position,
+    and finds the position of the n-th live entry, in O(log n). It is
+    built on first use and kept up to date as entries are added, removed
+    and moved; anything that moves every entry, like compaction, drops
+    it until it is next needed.
+*/
+
+#pragma once
+#ifndef RANKS_H
+#define RANKS_H
+#include <bit>
+#include <cstddef>
+
+#include "memory.h"
+
+namespace nmg
+{
+
+struct RankTree
+{
+    // 1-based: node i sums the live flags of positions [i - lowbit(i), i).
+    size_t* _tree;
+    size_t _capacity;
+    bool _valid;
+
+    RankTree()
+        : _tree(nullptr), _capacity(0), _valid(false)
+    {
+    }
+
+    static size_t lowbit(size_t i)
+    {
+        return i & (~i + 1);
+    }
+
+    /// @brief Builds the tree in O(used), reusing its allocation if it is
+    /// big enough.
+    /// @param alloc The allocator of the owning set.
+    /// @param alive The live flags of the store.
+    /// @param used The number of store positions in use.
+    /// @param capacity The capacity of the store.
+    template <typename Allocator> void build(const Allocator& alloc, const bool* alive, size_t used, size_t capacity)
+    {
+        if (_capacity < capacity)
+        {
+            release(alloc);
+            _tree = allocate_aligned<size_t>(alloc, capacity + 1);
+            _capacity = capacity;
+        }
+
+        for (size_t i = 1; i <= used; ++i)
+        {
+            _tree[i] = alive[i - 1];
+        }
+        // every node passes its sum on to the next node covering it.
+        for (size_t i = 1; i <= used; ++i)
+        {
+            size_t parent = i + lowbit(i);
+            if (parent <= used)
+            {
+                _tree[parent] += _tree[i];
+            }
+        }
+        _valid = true;
+    }
+
+    template <typename Allocator> void release(const Allocator& alloc)
+    {
+        if (_tree != nullptr)
+        {
+            deallocate_aligned(alloc, _tree, _capacity + 1);
+        }
+        *this = RankTree();
+    }
+
+    void invalidate()
+    {
+        _valid = false;
+    }
+
+    /// @brief Counts the live entries before a position.
+    size_t prefix(size_t pos) const
+    {
+        size_t count = 0;
+        for (size_t i = pos; i > 0; i -= lowbit(i))
+        {
+            count += _tree[i];
+        }
+        return count;
+    }
+
+    /// @brief Adds a live entry at the end of the store. Only the nodes
+    /// before it are read, so nodes left over past the end do no harm.
+    /// @param pos The position of the entry, the last in use.
+    void append(size_t pos)
+    {
+        size_t i = pos + 1;
+        _tree[i] = 1 + prefix(pos) - prefix(i - lowbit(i));
+    }
+
+    /// @brief Marks a position as live.
+    /// @param pos The position.
+    /// @param used The number of store positions in use.
+    void increment(size_t pos, size_t used)
+    {
+        for (size_t i = pos + 1; i <= used; i += lowbit(i))
+        {
+            ++_tree[i];
+        }
+    }
+
+    /// @brief Marks a position as dead.
+    /// @param pos The position.
+    /// @param used The number of store positions in use.
+    void decrement(size_t pos, size_t used)
+    {
+        for (size_t i = pos + 1; i <= used; i += lowbit(i))
+        {
+            --_tree[i];
+        }
+    }
+
+    /// @brief Finds the position of a live entry by its rank.
+    /// @param rank The number of live entries before it.
+    /// @param used The number of store positions in use.
+    /// @return The position, which must exist.
+    size_t find_nth(size_t rank, size_t used) const
+    {
+        size_t pos = 0;
+        for (size_t step = std::bit_floor(used); step != 0; step >>= 1)
+        {
+            if (pos + step <= used && _tree[pos + step] <= rank)
+            {
+                pos += step;
+                rank -= _tree[pos];
+            }
+        }
+        return pos;
+    }
+};
+} // namespace nmg
+
+#endif
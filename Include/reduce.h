@@ -0,0 +1,110 @@
+/*
+    Ways of reducing a hash to a bucket of an OSet table, picked with the
+    reduction member of the policy. A reduction also decides which bucket
+    counts the table may have, as a mask or a shift only works for powers
+    of two.
+
+    MaskReduction and FibonacciReduction keep the bucket count a power of
+    two, so reducing is a single and, or a multiply and a shift, rather
+    than a 64 bit division. The mask relies on the low bits of the hash
+    being well mixed, which hasher<T> makes sure of; the multiply spreads
+    every bit of the hash into the high bits it keeps. PrimeReduction
+    keeps a prime bucket count and takes the hash modulo it, which pays
+    for the division but copes best with hashes that mix poorly.
+*/
+
+#pragma once
+#ifndef REDUCE_H
+#define REDUCE_H
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+
+#include "hash.h"
+
+namespace nmg
+{
+
+struct MaskReduction
+{
+    /// @brief Rounds a bucket count up to one this reduction can use.
+    static size_t round(size_t count)
+    {
+        return std::bit_ceil(std::max<size_t>(count, 1));
+    }
+
+    /// @brief Reduces a hash to a bucket.
+    /// @param hval The hash.
+    /// @param count The bucket count, as returned by round.
+    static size_t index(hash_t hval, size_t count)
+    {
+        return static_cast<size_t>(hval) & (count - 1);
+    }
+};
+
+struct FibonacciReduction
+{
+    // 2^64 divided by the golden ratio.
+    static constexpr hash_t MULTIPLIER = 0x9E3779B97F4A7C15ull;
+
+    static size_t round(size_t count)
+    {
+        return std::bit_ceil(std::max<size_t>(count, 1));
+    }
+
+    static size_t index(hash_t hval, size_t count)
+    {
+        // the top log2(count) bits of the product; shifted in two steps so a
+        // single bucket does not shift by 64.
+        int bits = std::countr_zero(count);
+        return static_cast<size_t>((hval * MULTIPLIER) >> (63 - bits) >> 1);
+    }
+};
+
+struct PrimeReduction
+{
+    static size_t round(size_t count)
+    {
+        // the largest primes at or below 2^(k / 4), so a prime bucket count
+        // can stay within a fifth of what is asked for.
+        static constexpr size_t PRIMES[] = {
+            2ull, 3ull, 5ull, 7ull, 11ull, 13ull, 19ull, 23ull, 31ull, 37ull, 43ull, 53ull, 61ull, 73ull,
+            89ull, 107ull, 127ull, 151ull, 181ull, 211ull, 251ull, 293ull, 359ull, 421ull, 509ull, 607ull,
+            719ull, 859ull, 1021ull, 1217ull, 1447ull, 1721ull, 2039ull, 2423ull, 2887ull, 3433ull, 4093ull,
+            4861ull, 5791ull, 6883ull, 8191ull, 9739ull, 11579ull, 13763ull, 16381ull, 19483ull, 23167ull,
+            27551ull, 32749ull, 38959ull, 46337ull, 55103ull, 65521ull, 77933ull, 92681ull, 110183ull,
+            131071ull, 155863ull, 185363ull, 220421ull, 262139ull, 311743ull, 370723ull, 440863ull, 524287ull,
+            623477ull, 741431ull, 881743ull, 1048573ull, 1246963ull, 1482907ull, 1763477ull, 2097143ull,
+            2493947ull, 2965819ull, 3526949ull, 4194301ull, 4987891ull, 5931641ull, 7053911ull, 8388593ull,
+            9975773ull, 11863279ull, 14107889ull, 16777213ull, 19951579ull, 23726561ull, 28215799ull,
+            33554393ull, 39903161ull, 47453111ull, 56431601ull, 67108859ull, 79806317ull, 94906249ull,
+            112863197ull, 134217689ull, 159612653ull, 189812507ull, 225726379ull, 268435399ull, 319225331ull,
+            379625047ull, 451452823ull, 536870909ull, 638450677ull, 759250111ull, 902905643ull, 1073741789ull,
+            1276901389ull, 1518500213ull, 1805811263ull, 2147483647ull, 2553802819ull, 3037000493ull,
+            3611622593ull, 4294967291ull, 5107605623ull, 6074000981ull, 7223245193ull, 8589934583ull,
+            10215211333ull, 12148001963ull, 14446490407ull, 17179869143ull, 20430422659ull, 24296003933ull,
+            28892980777ull, 34359738337ull, 40860845323ull, 48592007969ull, 57785961617ull, 68719476731ull,
+            81721690669ull, 97184015963ull, 115571923283ull, 137438953447ull, 163443381347ull, 194368031953ull,
+            231143846573ull, 274877906899ull, 326886762677ull, 388736063993ull, 462287693117ull,
+            549755813881ull, 653773525333ull, 777472127983ull, 924575386247ull, 1099511627689ull,
+            1307547050737ull, 1554944255959ull, 1849150772647ull, 2199023255531ull, 2615094101531ull,
+            3109888511969ull, 3698301545273ull, 4398046511093ull, 5230188203083ull, 6219777023923ull,
+            7396603090601ull, 8796093022151ull, 10460376406211ull, 12439554047897ull, 14793206181211ull,
+            17592186044399ull, 20920752812471ull, 24879108095749ull, 29586412362443ull, 35184372088777ull,
+            41841505624913ull, 49758216191603ull, 59172824724859ull, 70368744177643ull, 83683011249863ull,
+            99516432383209ull, 118345649449801ull, 140737488355213ull, 167366022499763ull, 199032864766429ull,
+            236691298899611ull, 281474976710597ull};
+
+        const size_t* prime = std::lower_bound(std::begin(PRIMES), std::end(PRIMES), count);
+        return prime == std::end(PRIMES) ? count : *prime;
+    }
+
+    static size_t index(hash_t hval, size_t count)
+    {
+        return static_cast<size_t>(hval % count);
+    }
+};
+} // namespace nmg
+
+#endif
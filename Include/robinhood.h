@@ -0,0 +1,263 @@
+/*
+    A Robin Hood hash table for OSet, an alternative to the grouped table
+    in table.h, picked with the table_type member of the policy. Slots
+    are probed one after another from the home slot of a hash, so a probe
+    stays within neighbouring cache lines.
+
+    Every full slot records how far it is from its home slot. An insert
+    takes the slot of any entry closer to its own home than the insert
+    is, and carries on placing that entry instead, which keeps probe
+    lengths even. A lookup can stop at the first slot closer to home than
+    itself. Erasing shifts the run after a slot back by one, so no
+    deleted markers build up.
+
+    The distance shares 16 bits with the same seven bit tag of the hash
+    that table.h keeps in its control bytes, so a lookup reads both with
+    one load and only compares entries with the same home and tag. A
+    distance too long for its eight bits is kept at the largest one, which
+    lookups and inserts step past like any other, and erasing stops
+    shifting at it. Hitting it asks the set to grow the table.
+*/
+
+#pragma once
+#ifndef ROBINHOOD_H
+#define ROBINHOOD_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "group.h"
+#include "hash.h"
+#include "memory.h"
+#include "reduce.h"
+
+namespace nmg
+{
+
+template <typename Reduction, typename Index = size_t> struct RobinHoodTable
+{
+    // positions are stored as Index, narrower than size_t if the policy
+    // caps the set size, so more slots share a cache line.
+    using index_type = Index;
+
+    // per slot: zero when empty, else the distance from home plus one in
+    // the high byte, the retired bit and the tag of the hash in the low
+    // one. Retired slots keep their distance, so lookups still step past
+    // them.
+    using meta_t = uint16_t;
+    static constexpr int DIST_SHIFT = 8;
+    static constexpr meta_t DIST_ONE = meta_t(1) << DIST_SHIFT;
+    static constexpr meta_t DIST_MAX = 0xFF;
+    static constexpr meta_t META_RETIRED = 0x80;
+
+    meta_t* _meta;
+    Index* _slots;
+    size_t _capacity;
+    // empty slots that can still be filled before the table must grow.
+    size_t _growthLeft;
+
+    RobinHoodTable()
+        : _meta(nullptr), _slots(nullptr), _capacity(0), _growthLeft(0)
+    {
+    }
+
+    bool allocated() const
+    {
+        return _meta != nullptr;
+    }
+
+    /// @brief Rounds a capacity up to a slot count the reduction can use.
+    static size_t round_capacity(size_t capacity)
+    {
+        return Reduction::round(capacity);
+    }
+
+    /// @brief Allocates an empty table, releasing the current one.
+    /// @param alloc The allocator of the owning set.
+    /// @param capacity Number of slots, as returned by round_capacity.
+    /// @param maxLoad Number of slots that may be filled.
+    template <typename Allocator> void allocate(const Allocator& alloc, size_t capacity, size_t maxLoad)
+    {
+        release(alloc);
+        _capacity = capacity;
+        _meta = allocate_aligned<meta_t>(alloc, _capacity);
+        _slots = allocate_aligned<Index>(alloc, _capacity);
+        reset(maxLoad);
+    }
+
+    template <typename Allocator> void release(const Allocator& alloc)
+    {
+        if (allocated())
+        {
+            deallocate_aligned(alloc, _meta, _capacity);
+            deallocate_aligned(alloc, _slots, _capacity);
+        }
+        *this = RobinHoodTable();
+    }
+
+    template <typename Allocator> void copy_from(const Allocator& alloc, const RobinHoodTable& other)
+    {
+        release(alloc);
+        if (!other.allocated())
+        {
+            return;
+        }
+
+        _capacity = other._capacity;
+        _growthLeft = other._growthLeft;
+        _meta = allocate_aligned<meta_t>(alloc, _capacity);
+        _slots = allocate_aligned<Index>(alloc, _capacity);
+        std::copy(other._meta, other._meta + _capacity, _meta);
+        std::copy(other._slots, other._slots + _capacity, _slots);
+    }
+
+    /// @brief Empties every slot, keeping the allocation.
+    void reset(size_t maxLoad)
+    {
+        std::fill(_meta, _meta + _capacity, meta_t(0));
+        _growthLeft = maxLoad;
+    }
+
+    bool is_full(size_t slot) const
+    {
+        return _meta[slot] != 0 && (_meta[slot] & META_RETIRED) == 0;
+    }
+
+    /// @brief Finds the slot of an entry. Only entries with the same home
+    /// slot and tag are passed to matches, and the probe ends at the first
+    /// slot closer to its home than the probe is.
+    /// @param hval The hash of the item.
+    /// @param matches Called with a position, returns if it holds the item.
+    /// @return The slot, or NPOS if there is none.
+    template <typename Matches> size_t find(hash_t hval, Matches&& matches) const
+    {
+        size_t slot = home(hval);
+        for (meta_t want = DIST_ONE | tag(hval);; want = step(want))
+        {
+            // a full match also rules out retired slots.
+            meta_t meta = _meta[slot];
+            if (distance(meta) < distance(want))
+            {
+                return NPOS;
+            }
+            if (meta == want && matches(_slots[slot]))
+            {
+                return slot;
+            }
+            slot = next(slot);
+        }
+    }
+
+    /// @brief Prefetches the metadata and slots at the home slot of a hash.
+    void prefetch_home(hash_t hval) const
+    {
+        size_t slot = home(hval);
+        prefetch(_meta + slot);
+        prefetch(_slots + slot);
+    }
+
+    /// @brief Finds the first slot with the same home and tag as a hash,
+    /// without comparing any entries.
+    /// @return The slot, or NPOS if there is none.
+    size_t first_match(hash_t hval) const
+    {
+        size_t slot = home(hval);
+        for (meta_t want = DIST_ONE | tag(hval); distance(_meta[slot]) >= distance(want); want = step(want))
+        {
+            if (_meta[slot] == want)
+            {
+                return slot;
+            }
+            slot = next(slot);
+        }
+        return NPOS;
+    }
+
+    /// @brief Places a position in the table, displacing entries closer to
+    /// their home. The caller makes sure there is growth left.
+    /// @return False if a distance got too long to record, and the table
+    /// should grow.
+    bool place(size_t pos, hash_t hval)
+    {
+        size_t slot = home(hval);
+        meta_t meta = DIST_ONE | tag(hval);
+        Index index = static_cast<Index>(pos);
+        bool fits = true;
+        for (; _meta[slot] != 0; slot = next(slot), meta = step(meta))
+        {
+            fits &= distance(meta) != DIST_MAX;
+            if (distance(_meta[slot]) < distance(meta))
+            {
+                std::swap(_meta[slot], meta);
+                std::swap(_slots[slot], index);
+            }
+        }
+
+        _meta[slot] = meta;
+        _slots[slot] = index;
+        --_growthLeft;
+        return fits && distance(meta) != DIST_MAX;
+    }
+
+    /// @brief Empties a slot, shifting the entries after it that are away
+    /// from home back by one.
+    void erase(size_t slot)
+    {
+        for (size_t after = next(slot); distance(_meta[after]) > 1; after = next(after))
+        {
+            // the real distance of a capped entry is unknown, so it stays
+            // put behind a retired slot that lookups step past. Placing
+            // everything again drops it.
+            if (distance(_meta[after]) == DIST_MAX)
+            {
+                _meta[slot] = static_cast<meta_t>(DIST_MAX << DIST_SHIFT | META_RETIRED);
+                return;
+            }
+            _meta[slot] = _meta[after] - DIST_ONE;
+            _slots[slot] = _slots[after];
+            slot = after;
+        }
+        _meta[slot] = 0;
+        ++_growthLeft;
+    }
+
+    /// @brief Empties a slot of a table being rehashed away, without moving
+    /// any other slot, so slots not moved across yet stay in place.
+    void retire(size_t slot)
+    {
+        _meta[slot] |= META_RETIRED;
+    }
+
+    /// @brief The distance from home plus one recorded in a slot, zero when
+    /// the slot is empty.
+    static meta_t distance(meta_t meta)
+    {
+        return meta >> DIST_SHIFT;
+    }
+
+  private:
+    /// @brief One slot further from home, capped at the longest distance.
+    static meta_t step(meta_t meta)
+    {
+        return distance(meta) == DIST_MAX ? meta : static_cast<meta_t>(meta + DIST_ONE);
+    }
+
+    static meta_t tag(hash_t hval)
+    {
+        return static_cast<meta_t>(hash_tag(hval));
+    }
+
+    size_t home(hash_t hval) const
+    {
+        return Reduction::index(hash_home(hval), _capacity);
+    }
+
+    size_t next(size_t slot) const
+    {
+        return slot + 1 == _capacity ? 0 : slot + 1;
+    }
+};
+} // namespace nmg
+
+#endif
@@ -0,0 +1,212 @@
+/*
+    The OSet hash table. Slots hold positions into the entry store, each
+    with a control byte (see group.h). The table never looks at items
+    itself: lookups take a predicate that compares the entry at a
+    position, so one table type serves every OSet. The reduction (see
+    reduce.h) picks the first group probed for a hash.
+*/
+
+#pragma once
+#ifndef TABLE_H
+#define TABLE_H
+#include <algorithm>
+#include <cstddef>
+
+#include "group.h"
+#include "hash.h"
+#include "memory.h"
+#include "reduce.h"
+
+namespace nmg
+{
+
+template <typename Reduction, typename Index = size_t> struct IndexTable
+{
+    // positions are stored as Index, narrower than size_t if the policy
+    // caps the set size, so more slots share a cache line.
+    using index_type = Index;
+
+    ctrl_t* _ctrl;
+    Index* _slots;
+    size_t _capacity;
+    // empty slots that can still be filled before the table must grow.
+    size_t _growthLeft;
+
+    IndexTable()
+        : _ctrl(nullptr), _slots(nullptr), _capacity(0), _growthLeft(0)
+    {
+    }
+
+    bool allocated() const
+    {
+        return _ctrl != nullptr;
+    }
+
+    /// @brief Rounds a capacity up to whole groups, in a group count the
+    /// reduction can use.
+    static size_t round_capacity(size_t capacity)
+    {
+        return Reduction::round((capacity + Group::WIDTH - 1) / Group::WIDTH) * Group::WIDTH;
+    }
+
+    /// @brief Allocates an empty table, releasing the current one.
+    /// @param alloc The allocator of the owning set.
+    /// @param capacity Number of slots, as returned by round_capacity.
+    /// @param maxLoad Number of slots that may be filled.
+    template <typename Allocator> void allocate(const Allocator& alloc, size_t capacity, size_t maxLoad)
+    {
+        release(alloc);
+        _capacity = capacity;
+        _ctrl = allocate_aligned<ctrl_t>(alloc, _capacity);
+        _slots = allocate_aligned<Index>(alloc, _capacity);
+        reset(maxLoad);
+    }
+
+    template <typename Allocator> void release(const Allocator& alloc)
+    {
+        if (allocated())
+        {
+            deallocate_aligned(alloc, _ctrl, _capacity);
+            deallocate_aligned(alloc, _slots, _capacity);
+        }
+        *this = IndexTable();
+    }
+
+    template <typename Allocator> void copy_from(const Allocator& alloc, const IndexTable& other)
+    {
+        release(alloc);
+        if (!other.allocated())
+        {
+            return;
+        }
+
+        _capacity = other._capacity;
+        _growthLeft = other._growthLeft;
+        _ctrl = allocate_aligned<ctrl_t>(alloc, _capacity);
+        _slots = allocate_aligned<Index>(alloc, _capacity);
+        std::copy(other._ctrl, other._ctrl + _capacity, _ctrl);
+        std::copy(other._slots, other._slots + _capacity, _slots);
+    }
+
+    /// @brief Empties every slot, keeping the allocation.
+    void reset(size_t maxLoad)
+    {
+        std::fill(_ctrl, _ctrl + _capacity, CTRL_EMPTY);
+        _growthLeft = maxLoad;
+    }
+
+    bool is_full(size_t slot) const
+    {
+        return _ctrl[slot] >= 0;
+    }
+
+    /// @brief Finds the slot of an entry. Only slots whose control byte
+    /// matches the tag of the hash are passed to matches, and an empty slot
+    /// in the group ends the probe sequence.
+    /// @param hval The hash of the item.
+    /// @param matches Called with a position, returns if it holds the item.
+    /// @return The slot, or NPOS if there is none.
+    template <typename Matches> size_t find(hash_t hval, Matches&& matches) const
+    {
+        ctrl_t tag = hash_tag(hval);
+
+        for (ProbeSeq seq = probe(hval);; seq.next())
+        {
+            Group group(_ctrl + seq.offset());
+            for (GroupMask match = group.match(tag); match != 0;)
+            {
+                size_t slot = seq.offset() + pop_match(match);
+                if (matches(_slots[slot]))
+                {
+                    return slot;
+                }
+            }
+            if (group.match_empty() != 0)
+            {
+                return NPOS;
+            }
+        }
+    }
+
+    /// @brief Prefetches the control bytes and slots of the first group
+    /// probed for a hash.
+    void prefetch_home(hash_t hval) const
+    {
+        size_t offset = probe(hval).offset();
+        prefetch(_ctrl + offset);
+        prefetch(_slots + offset);
+    }
+
+    /// @brief Finds the first slot in the first group probed for a hash
+    /// whose tag matches, without comparing any entries.
+    /// @return The slot, or NPOS if there is none.
+    size_t first_match(hash_t hval) const
+    {
+        size_t offset = probe(hval).offset();
+        GroupMask match = Group(_ctrl + offset).match(hash_tag(hval));
+        return match == 0 ? NPOS : offset + std::countr_zero(match);
+    }
+
+    size_t find_free(hash_t hval) const
+    {
+        for (ProbeSeq seq = probe(hval);; seq.next())
+        {
+            GroupMask match = Group(_ctrl + seq.offset()).match_empty_or_deleted();
+            if (match != 0)
+            {
+                return seq.offset() + std::countr_zero(match);
+            }
+        }
+    }
+
+    /// @brief Places a position in the table. The caller makes sure there
+    /// is growth left.
+    /// @return True, probe sequences have no length to outgrow.
+    bool place(size_t pos, hash_t hval)
+    {
+        size_t slot = find_free(hval);
+
+        // deleted slots can be reused freely, empty ones use up the growth left.
+        if (_ctrl[slot] == CTRL_EMPTY)
+        {
+            --_growthLeft;
+        }
+
+        _ctrl[slot] = hash_tag(hval);
+        _slots[slot] = static_cast<Index>(pos);
+        return true;
+    }
+
+    void erase(size_t slot)
+    {
+        // a slot can go straight back to empty when its group already has an
+        // empty slot, as no probe sequence continues past this group.
+        size_t group = slot - slot % Group::WIDTH;
+        if (Group(_ctrl + group).match_empty() != 0)
+        {
+            _ctrl[slot] = CTRL_EMPTY;
+            ++_growthLeft;
+        }
+        else
+        {
+            _ctrl[slot] = CTRL_DELETED;
+        }
+    }
+
+    /// @brief Empties a slot of a table being rehashed away, leaving it
+    /// deleted so probe sequences still reach the slots past it.
+    void retire(size_t slot)
+    {
+        _ctrl[slot] = CTRL_DELETED;
+    }
+
+  private:
+    ProbeSeq probe(hash_t hval) const
+    {
+        size_t groups = _capacity / Group::WIDTH;
+        return ProbeSeq(Reduction::index(hash_home(hval), groups), groups);
+    }
+};
+} // namespace nmg
+
+#endif
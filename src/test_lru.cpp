@@ -0,0 +1,284 @@
+#include <cstdlib>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+#include <lru.h>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <random>
+
+template <typename Cache, typename Item> static std::vector<Item> contents(const Cache& cache)
+{
+    std::vector<Item> items;
+    for(const auto& item : cache)
+    {
+        items.push_back(item);
+    }
+    return items;
+}
+
+// a key that counts how often it is hashed.
+struct CountedKey
+{
+    int value;
+    static inline int hashes = 0;
+
+    bool operator==(const CountedKey& other) const
+    {
+        return value == other.value;
+    }
+};
+
+struct CountingHash
+{
+    hash_t operator()(const CountedKey& key) const
+    {
+        ++CountedKey::hashes;
+        return hash_integral(key.value);
+    }
+};
+
+TEST_CASE("LruSet evicts the least recently used item")
+{
+    std::vector<int> evicted;
+    nmg::LruSet<int> cache(3, [&](const int& item) { evicted.push_back(item); });
+
+    REQUIRE(cache.capacity() == 3);
+    REQUIRE(cache.add(1));
+    REQUIRE(cache.add(2));
+    REQUIRE(cache.add(3));
+    REQUIRE(evicted.empty());
+
+    REQUIRE(cache.touch(1));
+    REQUIRE(!cache.touch(4));
+    REQUIRE(cache.add(4));
+    REQUIRE(evicted == std::vector<int>{2});
+    REQUIRE(contents<nmg::LruSet<int>, int>(cache) == std::vector<int>{3, 1, 4});
+
+    // adding a cached item makes it the most recent, without evicting.
+    REQUIRE(!cache.add(3));
+    REQUIRE(contents<nmg::LruSet<int>, int>(cache) == std::vector<int>{1, 4, 3});
+    REQUIRE(cache.add(5));
+    REQUIRE(evicted == std::vector<int>{2, 1});
+    REQUIRE(cache.size() == 3);
+
+    REQUIRE(cache.hits() == 1);
+    REQUIRE(cache.misses() == 1);
+    REQUIRE(cache.contains(5));
+    REQUIRE(cache.hits() == 1);
+    cache.reset_stats();
+    REQUIRE(cache.hits() == 0);
+
+    REQUIRE(cache.remove(4));
+    REQUIRE(!cache.remove(4));
+    cache.clear();
+    REQUIRE(cache.empty());
+    REQUIRE(evicted.size() == 2);
+
+    REQUIRE_THROWS_AS(nmg::LruSet<int>(0), std::invalid_argument);
+}
+
+TEST_CASE("LruSet of strings is touched with string_views")
+{
+    nmg::LruSet<std::string> cache(2);
+    cache.add("alpha");
+    cache.add(std::string("beta"));
+    REQUIRE(cache.touch(std::string_view("alpha")));
+    cache.add("gamma");
+    REQUIRE(!cache.contains("beta"));
+    REQUIRE(cache.contains("alpha"));
+
+    nmg::LruSet<std::unique_ptr<int>> pointers(1);
+    REQUIRE(pointers.add(std::make_unique<int>(1)));
+    REQUIRE(pointers.add(std::make_unique<int>(2)));
+    REQUIRE(**pointers.begin() == 2);
+}
+
+TEST_CASE("LruMap gets, puts and evicts entries")
+{
+    std::vector<std::pair<std::string, int>> evicted;
+    nmg::LruMap<std::string, int> cache(2, [&](const std::string& key, int& value) {
+        evicted.emplace_back(key, value);
+    });
+
+    REQUIRE(cache.put("one", 1));
+    REQUIRE(cache.put("two", 2));
+    REQUIRE(*cache.get("one") == 1);
+    REQUIRE(cache.get(std::string_view("three")) == nullptr);
+
+    REQUIRE(cache.put("three", 3));
+    REQUIRE(evicted.size() == 1);
+    REQUIRE(evicted[0] == std::pair<std::string, int>("two", 2));
+
+    // assigning an existing key makes it the most recent.
+    REQUIRE(!cache.put("one", 11));
+    REQUIRE(cache.put("four", 4));
+    REQUIRE(evicted.back().first == "three");
+    REQUIRE(*cache.get(std::string("one")) == 11);
+
+    *cache.get("four") = 44;
+    REQUIRE(cache.begin()->first == "one");
+    REQUIRE(std::next(cache.begin())->second == 44);
+
+    REQUIRE(cache.hits() == 3);
+    REQUIRE(cache.misses() == 1);
+    REQUIRE(cache.contains("one"));
+    REQUIRE(cache.remove("one"));
+    REQUIRE(!cache.contains("one"));
+    REQUIRE(cache.size() == 1);
+}
+
+TEST_CASE("LruMap matches a list and map model")
+{
+    std::default_random_engine random;
+    std::uniform_int_distribution<int> keys(0, 99);
+
+    const size_t capacity = 40;
+    nmg::LruMap<int, int> cache(capacity);
+    std::list<std::pair<const int, int>> order;
+    std::unordered_map<int, std::list<std::pair<const int, int>>::iterator> index;
+
+    for(int step = 0; step < 50000; ++step)
+    {
+        int key = keys(random);
+        auto found = index.find(key);
+        if(step % 3 == 0)
+        {
+            int* value = cache.get(key);
+            REQUIRE((value != nullptr) == (found != index.end()));
+            if(value != nullptr)
+            {
+                REQUIRE(*value == found->second->second);
+                order.splice(order.end(), order, found->second);
+            }
+        }
+        else
+        {
+            REQUIRE(cache.put(key, step) == (found == index.end()));
+            if(found != index.end())
+            {
+                found->second->second = step;
+                order.splice(order.end(), order, found->second);
+            }
+            else
+            {
+                if(order.size() == capacity)
+                {
+                    index.erase(order.front().first);
+                    order.pop_front();
+                }
+                order.emplace_back(key, step);
+                index[key] = std::prev(order.end());
+            }
+        }
+        REQUIRE(cache.size() == order.size());
+    }
+
+    auto expected = order.begin();
+    for(const auto& entry : cache)
+    {
+        REQUIRE(entry == *expected++);
+    }
+}
+
+TEST_CASE("LRU caches hash a missing item once")
+{
+    nmg::LruSet<CountedKey, CountingHash> cache(2);
+    cache.add({1});
+    cache.add({2});
+
+    // the eviction finds the front item by its cached hash.
+    CountedKey::hashes = 0;
+    REQUIRE(cache.add({3}));
+    REQUIRE(CountedKey::hashes == 1);
+    REQUIRE(!cache.add({2}));
+    REQUIRE(CountedKey::hashes == 2);
+    REQUIRE(!cache.contains({1}));
+
+    nmg::LruMap<CountedKey, int, CountingHash> map(2);
+    map.put({1}, 1);
+    map.put({2}, 2);
+    CountedKey::hashes = 0;
+    REQUIRE(map.put({3}, 3));
+    REQUIRE(CountedKey::hashes == 1);
+    REQUIRE(!map.put({3}, 33));
+    REQUIRE(CountedKey::hashes == 2);
+    REQUIRE(*map.get({3}) == 33);
+    REQUIRE(!map.contains({1}));
+}
+
+// hashes a pair of ints, so it only takes whole pairs.
+struct PairHash
+{
+    hash_t operator()(const std::pair<int, int>& key) const
+    {
+        return hash_integral(static_cast<hash_t>(key.first) * 31 + static_cast<hash_t>(key.second));
+    }
+};
+
+TEST_CASE("LruMap takes keys that are pairs themselves")
+{
+    nmg::LruMap<std::pair<int, int>, int, PairHash> cache(2);
+    REQUIRE(cache.put({1, 2}, 12));
+    REQUIRE(cache.put({2, 1}, 21));
+    REQUIRE(*cache.get({1, 2}) == 12);
+    REQUIRE(cache.put({3, 3}, 33));
+    REQUIRE(!cache.contains({2, 1}));
+    REQUIRE(cache.get({2, 1}) == nullptr);
+    REQUIRE(cache.remove({1, 2}));
+    REQUIRE(cache.size() == 1);
+}
+
+TEST_CASE("LruSet evicts without walking dead entries once full")
+{
+    // each eviction moves the head of the store past the evicted item, so
+    // the next one starts at a live entry rather than walking the dead ones.
+    const int capacity = 1000;
+    nmg::LruSet<int> cache(capacity);
+    for(int i = 0; i < capacity; ++i)
+    {
+        cache.add(i);
+    }
+    for(int i = capacity; i < capacity * 4; ++i)
+    {
+        REQUIRE(cache.add(i));
+        const auto& store = cache.set().store();
+        REQUIRE(store._alive[store._head]);
+        REQUIRE(*cache.begin() == i - capacity + 1);
+    }
+    REQUIRE(cache.size() == capacity);
+    REQUIRE(!cache.contains(capacity * 3 - 1));
+}
+
+struct SmallPolicy : nmg::DefaultPolicy
+{
+    static constexpr size_t small_size = 4;
+};
+
+TEST_CASE("LRU caches take a policy and an allocator")
+{
+    nmg::LruSet<int, nmg::hasher<int>, nmg::default_equal<int>, SmallPolicy> set(3);
+    set.add(1);
+    set.add(2);
+    set.add(3);
+    set.touch(1);
+    set.add(4);
+    REQUIRE(contents<decltype(set), int>(set) == std::vector<int>{3, 1, 4});
+
+    std::pmr::monotonic_buffer_resource resource;
+    using Allocator = std::pmr::polymorphic_allocator<std::pair<const int, int>>;
+    nmg::LruMap<int, int, nmg::hasher<int>, nmg::default_equal<int>, SmallPolicy, Allocator> map(
+        2, nmg::LruMap<int, int>::eviction_callback(), Allocator(&resource));
+    REQUIRE(map.set().get_allocator().resource() == &resource);
+    map.put(1, 10);
+    map.put(2, 20);
+    REQUIRE(*map.get(1) == 10);
+    map.put(3, 30);
+    REQUIRE(!map.contains(2));
+    REQUIRE(map.begin()->first == 1);
+    REQUIRE(std::next(map.begin())->second == 30);
+}
@@ -0,0 +1,256 @@
+#include <cstdlib>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+#include <omap.h>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <random>
+
+TEST_CASE("OMap iterates in insertion order")
+{
+    nmg::OMap<std::string, int> omap = {{"one", 1}, {"two", 2}, {"three", 3}, {"one", 11}};
+    REQUIRE(omap.size() == 3);
+
+    std::vector<std::string> keys;
+    for(auto& [key, value] : omap)
+    {
+        keys.push_back(key);
+        value *= 10;
+    }
+    REQUIRE(keys == std::vector<std::string>{"one", "two", "three"});
+    REQUIRE(omap.at("one") == 10);
+    REQUIRE(omap.rbegin()->first == "three");
+
+    static_assert(std::is_same_v<decltype(*omap.begin()), std::pair<const std::string, int>&>);
+    static_assert(std::is_same_v<decltype(*omap.cbegin()), const std::pair<const std::string, int>&>);
+    static_assert(std::is_nothrow_move_constructible_v<nmg::OMap<std::string, int>>);
+    static_assert(std::is_nothrow_move_assignable_v<nmg::OMap<std::string, int>>);
+}
+
+TEST_CASE("OMap operator[] adds default values")
+{
+    nmg::OMap<std::string, int> counts;
+    for(std::string word : {"a", "b", "a", "c", "a", "b"})
+    {
+        ++counts[word];
+    }
+    REQUIRE(counts.size() == 3);
+    REQUIRE(counts["a"] == 3);
+    REQUIRE(counts.at("b") == 2);
+    REQUIRE(counts[std::string("c")] == 1);
+    REQUIRE(counts.begin()->first == "a");
+    REQUIRE_THROWS_AS(counts.at("d"), std::out_of_range);
+
+    const nmg::OMap<std::string, int>& constCounts = counts;
+    REQUIRE(constCounts.at("a") == 3);
+    REQUIRE(constCounts.find("z") == constCounts.end());
+}
+
+TEST_CASE("OMap try_emplace and insert_or_assign")
+{
+    nmg::OMap<std::string, std::unique_ptr<int>> omap;
+
+    auto [first, added] = omap.try_emplace("key", new int(1));
+    REQUIRE(added);
+    REQUIRE(*first->second == 1);
+
+    // nothing is constructed or moved on a hit.
+    std::string key = "key";
+    auto value = std::make_unique<int>(2);
+    auto [again, addedAgain] = omap.try_emplace(std::move(key), std::move(value));
+    REQUIRE(!addedAgain);
+    REQUIRE(again == first);
+    REQUIRE(key == "key");
+    REQUIRE(value != nullptr);
+
+    auto [assigned, addedAssign] = omap.insert_or_assign("key", std::move(value));
+    REQUIRE(!addedAssign);
+    REQUIRE(*assigned->second == 2);
+    REQUIRE(value == nullptr);
+
+    REQUIRE(omap.insert_or_assign(std::string("other"), std::make_unique<int>(3)).second);
+    REQUIRE(omap.size() == 2);
+    REQUIRE(omap.begin()->first == "key");
+}
+
+TEST_CASE("OMap is searched with string_views")
+{
+    nmg::OMap<std::string, int> omap = {{"alpha", 1}, {"beta", 2}};
+    std::string_view beta = "beta";
+    REQUIRE(omap.contains(beta));
+    REQUIRE(omap.find(beta)->second == 2);
+    REQUIRE(omap.remove(beta));
+    REQUIRE(!omap.contains("beta"));
+    REQUIRE(!omap.remove("beta"));
+}
+
+TEST_CASE("OMap matches std::map under random changes")
+{
+    std::default_random_engine random;
+    std::uniform_int_distribution<int> keys(0, 499);
+
+    nmg::OMap<int, int> omap;
+    std::map<int, int> expected;
+    for(int step = 0; step < 50000; ++step)
+    {
+        int key = keys(random);
+        switch(step % 4)
+        {
+        case 0:
+            REQUIRE(omap.insert_or_assign(key, step).second == expected.insert_or_assign(key, step).second);
+            break;
+        case 1:
+            REQUIRE(omap.remove(key) == (expected.erase(key) == 1));
+            break;
+        case 2:
+            omap[key] += step;
+            expected[key] += step;
+            break;
+        default:
+        {
+            auto found = omap.find(key);
+            REQUIRE((found != omap.end()) == expected.contains(key));
+            if(found != omap.end())
+            {
+                REQUIRE(found->second == expected[key]);
+                omap.erase(found);
+                expected.erase(key);
+            }
+        }
+        }
+    }
+
+    REQUIRE(omap.size() == expected.size());
+    for(const auto& [key, value] : omap)
+    {
+        REQUIRE(expected.at(key) == value);
+    }
+}
+
+TEST_CASE("pmr OMap takes its memory from the resource")
+{
+    std::pmr::monotonic_buffer_resource resource;
+    nmg::OMap<int, int, nmg::hasher<int>, nmg::default_equal<int>, nmg::DefaultPolicy,
+              std::pmr::polymorphic_allocator<std::pair<const int, int>>>
+        omap(&resource);
+    for(int i = 0; i < 1000; ++i)
+    {
+        omap[i] = i;
+    }
+    REQUIRE(omap.get_allocator().resource() == &resource);
+    REQUIRE(omap.at(999) == 999);
+}
+
+TEST_CASE("OMap keeps its entries through store growth and compaction")
+{
+    // keys too long for the small string buffer, so a bad key copy shows up.
+    auto key = [](int i) { return std::string(40, 'k') + std::to_string(i); };
+
+    nmg::OMap<std::string, std::unique_ptr<int>> omap;
+    for(int i = 0; i < 2000; ++i)
+    {
+        omap.try_emplace(key(i), std::make_unique<int>(i));
+    }
+    for(int i = 0; i < 2000; i += 2)
+    {
+        omap.remove(key(i));
+    }
+    for(int i = 2000; i < 4000; ++i)
+    {
+        omap.try_emplace(key(i), std::make_unique<int>(i));
+    }
+
+    REQUIRE(omap.size() == 3000);
+    int expected = 1;
+    for(const auto& [entryKey, value] : omap)
+    {
+        REQUIRE(entryKey == key(expected));
+        REQUIRE(*value == expected);
+        expected = expected == 1999 ? 2000 : expected + (expected < 2000 ? 2 : 1);
+    }
+}
+
+// hashes a pair of ints, so it only takes whole pairs.
+struct PairHash
+{
+    hash_t operator()(const std::pair<int, int>& key) const
+    {
+        return hash_integral(static_cast<hash_t>(key.first) * 31 + static_cast<hash_t>(key.second));
+    }
+};
+
+TEST_CASE("OMap takes keys that are pairs themselves")
+{
+    nmg::OMap<std::pair<int, int>, int, PairHash> omap;
+    for(int i = 0; i < 100; ++i)
+    {
+        REQUIRE(omap.try_emplace(std::pair(i, -i), i).second);
+    }
+    REQUIRE(!omap.try_emplace(std::pair(5, -5), 0).second);
+    REQUIRE(omap.at(std::pair(7, -7)) == 7);
+    REQUIRE(!omap.contains(std::pair(7, 7)));
+    REQUIRE(omap.remove(std::pair(3, -3)));
+    REQUIRE(omap.begin()->first == std::pair(0, 0));
+    REQUIRE(omap.size() == 99);
+}
+
+// a key that can only be moved, and counts how often it is.
+struct MoveOnlyKey
+{
+    int value;
+    static inline int moves = 0;
+
+    explicit MoveOnlyKey(int value)
+        : value(value)
+    {
+    }
+
+    MoveOnlyKey(MoveOnlyKey&& other) noexcept
+        : value(other.value)
+    {
+        ++moves;
+    }
+
+    MoveOnlyKey(const MoveOnlyKey&) = delete;
+
+    bool operator==(const MoveOnlyKey& other) const
+    {
+        return value == other.value;
+    }
+};
+
+struct MoveOnlyKeyHash
+{
+    hash_t operator()(const MoveOnlyKey& key) const
+    {
+        return hash_integral(static_cast<hash_t>(key.value));
+    }
+};
+
+TEST_CASE("OMap moves its keys around the store rather than copying them")
+{
+    nmg::OMap<MoveOnlyKey, std::string, MoveOnlyKeyHash> omap;
+    for(int i = 0; i < 2000; ++i)
+    {
+        omap.try_emplace(MoveOnlyKey(i), std::to_string(i));
+    }
+    for(int i = 0; i < 2000; i += 2)
+    {
+        omap.remove(MoveOnlyKey(i));
+    }
+    // one move per add puts the key in, the rest relocate it.
+    MoveOnlyKey::moves = 0;
+    for(int i = 2000; i < 4000; ++i)
+    {
+        omap.try_emplace(MoveOnlyKey(i), std::to_string(i));
+    }
+    REQUIRE(MoveOnlyKey::moves > 2000);
+
+    REQUIRE(omap.size() == 3000);
+    REQUIRE(omap.at(MoveOnlyKey(1999)) == "1999");
+    REQUIRE(omap.begin()->first.value == 1);
+}
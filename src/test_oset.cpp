@@ -2,14 +2,45 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
 #include <oset.h>
+#include <memory>
+#include <memory_resource>
+#include <string>
 #include <vector>
+#include <list>
+#include <unordered_map>
 #include <set>
+#include <sstream>
+#include <iterator>
+#include <algorithm>
 #include <random>
 #include "gravedata.h"
 
 using gint = nmg::GraveData;
 using gset = nmg::OSet<gint>;
 
+// a key that counts how often it is hashed.
+struct HashCounted
+{
+    int value;
+    static inline int hashes = 0;
+
+    bool operator==(const HashCounted& other) const
+    {
+        return value == other.value;
+    }
+};
+
+struct CountingHash
+{
+    hash_t operator()(const HashCounted& obj) const
+    {
+        ++HashCounted::hashes;
+        return hash_integral(obj.value);
+    }
+};
+
+template <typename T, typename Policy> using PolicySet = nmg::OSet<T, nmg::hasher<T>, nmg::default_equal<T>, Policy>;
+
 
 static std::default_random_engine randomVar;
 
@@ -225,7 +256,7 @@ TEST_CASE("OSet can re-add items after removal")
     auto data = generate_testdata(100);
     gset oset;
 
-    for(int i = 0; i < data.size(); ++i)
+    for(size_t i = 0; i < data.size(); ++i)
     {
         oset.add(data[i]);
     }
@@ -288,3 +319,2278 @@ TEST_CASE("OSet removal maintains order")
     }
     REQUIRE_EQ(gint::count(), data.size());
 }
+
+TEST_CASE("OSet keeps order when removed entries are compacted")
+{
+    gint::init();
+    auto data = generate_testdata(200);
+    gset oset;
+
+    for(auto a : data)
+    {
+        oset.add(a);
+    }
+
+    std::vector<int> expected;
+    for(size_t i = 0; i < data.size(); ++i)
+    {
+        if(i % 3 == 0)
+        {
+            REQUIRE(oset.remove(data[i]));
+        }
+        else
+        {
+            expected.push_back(data[i]);
+        }
+    }
+
+    // re-adding the removed items grows the entry array, compacting it.
+    for(size_t i = 0; i < data.size(); i += 3)
+    {
+        REQUIRE(oset.add(data[i]));
+        expected.push_back(data[i]);
+    }
+
+    REQUIRE(oset.size() == expected.size());
+    auto osit = oset.begin();
+    for(auto a : expected)
+    {
+        REQUIRE(oset.contains(a));
+        REQUIRE_EQ(*osit, a);
+        ++osit;
+    }
+    REQUIRE_EQ(osit, oset.end());
+    REQUIRE_EQ(gint::count(), expected.size());
+}
+
+TEST_CASE("OSet copies and moves")
+{
+    gint::init();
+    auto data = generate_testdata(50);
+    gset oset;
+
+    for(auto a : data)
+    {
+        oset.add(a);
+    }
+    oset.remove(data[10]);
+
+    gset copy(oset);
+    REQUIRE(copy.size() == oset.size());
+    REQUIRE(!copy.contains(data[10]));
+    REQUIRE(copy.contains(data[11]));
+    REQUIRE_EQ(gint::count(), 2 * oset.size());
+
+    gset moved(std::move(copy));
+    REQUIRE(moved.size() == oset.size());
+    REQUIRE(copy.empty());
+    REQUIRE(copy.begin() == copy.end());
+
+    copy = moved;
+    REQUIRE(copy.size() == moved.size());
+    REQUIRE(*copy.begin() == data[0]);
+    REQUIRE_EQ(gint::count(), 3 * oset.size());
+}
+
+TEST_CASE("OSet moves without throwing, so a vector of sets moves them")
+{
+    static_assert(std::is_nothrow_move_constructible_v<nmg::OSet<int>>);
+    static_assert(std::is_nothrow_move_assignable_v<nmg::OSet<std::string>>);
+    static_assert(std::is_nothrow_move_constructible_v<nmg::pmr::OSet<int>>);
+    // polymorphic allocators may differ, and then items are moved one by one.
+    static_assert(!std::is_nothrow_move_assignable_v<nmg::pmr::OSet<int>>);
+
+    std::vector<nmg::OSet<std::string>> sets(1);
+    sets[0].add("first");
+    auto first = sets[0].cbegin();
+    const std::string* item = &*first;
+    for(int i = 0; i < 100; ++i)
+    {
+        sets.emplace_back().add(std::to_string(i));
+    }
+    auto moved = sets[0].cbegin();
+    REQUIRE(&*moved == item);
+}
+
+TEST_CASE("OSet finds items among many collisions and deletions")
+{
+    gint::init();
+    auto data = generate_testdata(5000);
+    gset oset;
+
+    for(auto a : data)
+    {
+        oset.add(a);
+    }
+
+    // churn through the table so it fills with deleted slots.
+    for(int round = 0; round < 4; ++round)
+    {
+        for(size_t i = round; i < data.size(); i += 4)
+        {
+            REQUIRE(oset.remove(data[i]));
+            REQUIRE(!oset.contains(data[i]));
+        }
+        for(size_t i = round; i < data.size(); i += 4)
+        {
+            REQUIRE(oset.add(data[i]));
+        }
+    }
+
+    REQUIRE(oset.size() == data.size());
+    for(auto a : data)
+    {
+        REQUIRE(oset.contains(a));
+        REQUIRE(!oset.contains(a + 5000 * 1000 + 1));
+    }
+    REQUIRE_EQ(gint::count(), data.size());
+}
+
+struct HalfFullPolicy : nmg::DefaultPolicy
+{
+    static constexpr float max_load_factor = 0.5f;
+    static constexpr float growth_factor = 1.5f;
+    static constexpr size_t min_capacity = 128;
+};
+
+TEST_CASE("OSet growth follows its policy")
+{
+    gint::init();
+    auto data = generate_testdata(1000);
+    PolicySet<gint, HalfFullPolicy> oset;
+
+    REQUIRE(oset.capacity() == 0);
+    oset.add(data[0]);
+    REQUIRE(oset.capacity() == 128);
+
+    for(auto a : data)
+    {
+        oset.add(a);
+        REQUIRE(oset.load_factor() <= 0.5f);
+    }
+    REQUIRE(oset.size() == data.size());
+    REQUIRE(oset.capacity() < 4 * data.size());
+
+    gset other;
+    other.max_load_factor(0.25f);
+    other.growth_factor(3.0f);
+    REQUIRE(other.max_load_factor() == 0.25f);
+    REQUIRE_THROWS_AS(other.max_load_factor(1.5f), std::invalid_argument);
+    REQUIRE_THROWS_AS(other.growth_factor(1.0f), std::invalid_argument);
+    for(auto a : data)
+    {
+        other.add(a);
+        REQUIRE(other.load_factor() <= 0.25f);
+    }
+    REQUIRE_EQ(gint::count(), 2 * data.size());
+}
+
+TEST_CASE("OSet reserve makes room up front")
+{
+    gint::init();
+    auto data = generate_testdata(500);
+    gset oset(data.size());
+
+    auto capacity = oset.capacity();
+    REQUIRE(capacity >= data.size());
+    for(auto a : data)
+    {
+        oset.add(a);
+    }
+    REQUIRE(oset.capacity() == capacity);
+
+    oset.reserve(10);
+    REQUIRE(oset.capacity() == capacity);
+    REQUIRE_EQ(gint::count(), data.size());
+}
+
+TEST_CASE("OSet rehash and shrink_to_fit keep items in order")
+{
+    gint::init();
+    auto data = generate_testdata(500);
+    gset oset;
+
+    for(auto a : data)
+    {
+        oset.add(a);
+    }
+    for(int i = 0; i < 400; ++i)
+    {
+        oset.remove(data[i]);
+    }
+
+    oset.rehash(4096);
+    REQUIRE(oset.capacity() >= 4096);
+
+    oset.shrink_to_fit();
+    REQUIRE(oset.capacity() < 4096);
+    REQUIRE(oset.size() == 100);
+
+    auto osit = oset.begin();
+    for(size_t i = 400; i < data.size(); ++i)
+    {
+        REQUIRE(oset.contains(data[i]));
+        REQUIRE_EQ(*osit, data[i]);
+        ++osit;
+    }
+    REQUIRE_EQ(gint::count(), 100);
+}
+
+TEST_CASE("OSet reset keeps its capacity")
+{
+    gint::init();
+    auto data = generate_testdata(300);
+    gset oset;
+
+    for(auto a : data)
+    {
+        oset.add(a);
+    }
+    auto capacity = oset.capacity();
+
+    oset.reset();
+    REQUIRE(oset.empty());
+    REQUIRE(oset.begin() == oset.end());
+    REQUIRE(oset.capacity() == capacity);
+    REQUIRE_EQ(gint::count(), 0);
+
+    for(auto a : data)
+    {
+        REQUIRE(!oset.contains(a));
+        REQUIRE(oset.add(a));
+    }
+    REQUIRE(oset.capacity() == capacity);
+    REQUIRE_EQ(gint::count(), data.size());
+}
+
+TEST_CASE("OSet never hashes an item again once it is stored")
+{
+    static_assert(nmg::Entry<HashCounted>::CACHED);
+    static_assert(!nmg::Entry<int>::CACHED);
+
+    nmg::OSet<HashCounted, CountingHash> oset;
+    HashCounted::hashes = 0;
+
+    for(int i = 0; i < 2000; ++i)
+    {
+        oset.add(HashCounted{i});
+    }
+    REQUIRE(oset.capacity() > nmg::DefaultPolicy::min_capacity);
+    REQUIRE_EQ(HashCounted::hashes, 2000);
+
+    oset.rehash(oset.capacity() * 4);
+    REQUIRE_EQ(HashCounted::hashes, 2000);
+
+    REQUIRE(oset.remove(HashCounted{7}));
+    REQUIRE(oset.contains(HashCounted{8}));
+    REQUIRE_EQ(HashCounted::hashes, 2002);
+}
+
+TEST_CASE("OSet of integral keys works without cached hashes")
+{
+    auto data = generate_testdata(1000);
+    nmg::OSet<int> oset;
+
+    for(auto a : data)
+    {
+        REQUIRE(oset.add(a));
+    }
+    for(size_t i = 0; i < data.size(); i += 2)
+    {
+        REQUIRE(oset.remove(data[i]));
+    }
+
+    auto osit = oset.begin();
+    for(size_t i = 1; i < data.size(); i += 2)
+    {
+        REQUIRE(oset.contains(data[i]));
+        REQUIRE(!oset.contains(data[i - 1]));
+        REQUIRE_EQ(*osit, data[i]);
+        ++osit;
+    }
+}
+
+struct IncrementalPolicy : nmg::DefaultPolicy
+{
+    static constexpr size_t rehash_budget = 8;
+};
+
+TEST_CASE("OSet rehashes incrementally with a rehash budget")
+{
+    gint::init();
+    auto data = generate_testdata(3000);
+    PolicySet<gint, IncrementalPolicy> oset;
+
+    bool sawRehash = false;
+    for(size_t i = 0; i < data.size(); ++i)
+    {
+        REQUIRE(oset.add(data[i]));
+        sawRehash = sawRehash || oset.rehashing();
+
+        // items in either table are found, and removable.
+        REQUIRE(oset.contains(data[i / 2]));
+        if(i % 7 == 0)
+        {
+            REQUIRE(oset.remove(data[i / 2]));
+            REQUIRE(!oset.contains(data[i / 2]));
+            REQUIRE(oset.add(data[i / 2]));
+        }
+    }
+    REQUIRE(sawRehash);
+    REQUIRE(oset.size() == data.size());
+    REQUIRE_EQ(gint::count(), data.size());
+
+    gset copy;
+    for(auto a : oset)
+    {
+        copy.add(a);
+    }
+    for(auto a : data)
+    {
+        REQUIRE(oset.contains(a));
+        REQUIRE(copy.contains(a));
+    }
+}
+
+TEST_CASE("OSet rehash_step moves a rehash along")
+{
+    gint::init();
+    PolicySet<gint, IncrementalPolicy> oset;
+    oset.rehash_budget(1);
+
+    int i = 0;
+    while(!oset.rehashing())
+    {
+        oset.add(i++);
+    }
+    REQUIRE(!oset.rehash_step(oset.capacity()));
+    REQUIRE(!oset.rehashing());
+    REQUIRE(!oset.rehash_step(10));
+
+    for(int j = 0; j < i; ++j)
+    {
+        REQUIRE(oset.contains(j));
+    }
+    REQUIRE_EQ(gint::count(), i);
+}
+
+TEST_CASE("OSet recycles removed entries under churn")
+{
+    gint::init();
+    auto data = generate_testdata(2000);
+    gset oset;
+
+    for(int i = 0; i < 500; ++i)
+    {
+        oset.add(data[i]);
+    }
+    auto capacity = oset.capacity();
+
+    // add/remove pairs keep the size steady, so neither the table nor the
+    // entries should grow.
+    for(size_t i = 500; i < data.size(); ++i)
+    {
+        REQUIRE(oset.add(data[i]));
+        REQUIRE(oset.remove(data[i - 500]));
+    }
+    REQUIRE(oset.size() == 500);
+    REQUIRE(oset.capacity() == capacity);
+
+    auto osit = oset.begin();
+    for(size_t i = data.size() - 500; i < data.size(); ++i)
+    {
+        REQUIRE_EQ(*osit, data[i]);
+        ++osit;
+    }
+    REQUIRE_EQ(gint::count(), 500);
+}
+
+TEST_CASE("OSet erases at the front without walking dead entries")
+{
+    // the head of the store moves past each erased front item, so the next
+    // begin() starts at a live entry rather than walking the dead ones.
+    const int size = 10000;
+    nmg::OSet<int> oset;
+    for(int i = 0; i < size; ++i)
+    {
+        oset.add(i);
+    }
+    for(int i = size; i < size * 4; ++i)
+    {
+        oset.erase(oset.begin());
+        const auto& store = oset.store();
+        REQUIRE(store._alive[store._head]);
+        REQUIRE(*oset.begin() == i - size + 1);
+        oset.add(i);
+    }
+    REQUIRE(oset.size() == size);
+    REQUIRE(*oset.rbegin() == size * 4 - 1);
+}
+
+// a memory resource that counts what it hands out.
+struct CountingResource : std::pmr::memory_resource
+{
+    size_t outstanding = 0;
+    size_t allocations = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        outstanding += bytes;
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        outstanding -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+TEST_CASE("pmr OSet takes all its memory from the resource")
+{
+    gint::init();
+    auto data = generate_testdata(1000);
+    CountingResource resource;
+
+    {
+        nmg::pmr::OSet<gint> oset(&resource);
+        for(auto a : data)
+        {
+            oset.add(a);
+        }
+        REQUIRE(resource.allocations > 0);
+        REQUIRE(resource.outstanding > 0);
+        REQUIRE(oset.get_allocator().resource() == &resource);
+
+        nmg::pmr::OSet<gint> copy(oset, &resource);
+        REQUIRE(copy.size() == oset.size());
+        REQUIRE(copy.contains(data[5]));
+    }
+    REQUIRE(resource.outstanding == 0);
+    REQUIRE_EQ(gint::count(), 0);
+}
+
+TEST_CASE("pmr OSet moves between resources by moving items")
+{
+    gint::init();
+    auto data = generate_testdata(100);
+    CountingResource first;
+    CountingResource second;
+
+    nmg::pmr::OSet<gint> source(&first);
+    nmg::pmr::OSet<gint> target(&second);
+    for(auto a : data)
+    {
+        source.add(a);
+    }
+
+    target = std::move(source);
+    REQUIRE(target.size() == data.size());
+    REQUIRE(target.get_allocator().resource() == &second);
+    REQUIRE(first.outstanding == 0);
+
+    auto osit = target.begin();
+    for(auto a : data)
+    {
+        REQUIRE(target.contains(a));
+        REQUIRE_EQ(*osit, a);
+        ++osit;
+    }
+    REQUIRE_EQ(gint::count(), data.size());
+}
+
+TEST_CASE("pmr OSet works on a monotonic buffer")
+{
+    std::pmr::monotonic_buffer_resource arena;
+    nmg::pmr::OSet<int> oset(&arena);
+
+    for(int i = 0; i < 1000; ++i)
+    {
+        oset.add(i * 7);
+    }
+    for(int i = 0; i < 1000; ++i)
+    {
+        REQUIRE(oset.contains(i * 7));
+    }
+}
+
+TEST_CASE("pmr OSet gives allocator-aware items its resource")
+{
+    CountingResource resource;
+    CountingResource other;
+    CountingResource copies;
+    {
+        nmg::pmr::OSet<std::pmr::string> oset(&resource);
+        for(int i = 0; i < 200; ++i)
+        {
+            // too long to fit in the string object itself.
+            std::pmr::string item(std::string(40, 'a' + i % 26) + std::to_string(i), &other);
+            if(i % 2 == 0)
+            {
+                oset.add(item);
+            }
+            else
+            {
+                oset.add(std::move(item));
+            }
+        }
+        oset.try_emplace(std::string_view("a key built in place, too long to fit in the string"));
+        REQUIRE(other.outstanding == 0);
+        for(auto it = oset.cbegin(); it != oset.cend(); ++it)
+        {
+            REQUIRE(it->get_allocator().resource() == &resource);
+        }
+
+        nmg::pmr::OSet<std::pmr::string> copy(oset, &copies);
+        REQUIRE(copy.size() == oset.size());
+        REQUIRE(copy.cbegin()->get_allocator().resource() == &copies);
+    }
+    REQUIRE(resource.outstanding == 0);
+    REQUIRE(copies.outstanding == 0);
+}
+
+struct Point
+{
+    int x;
+    int y;
+
+    bool operator==(const Point& other) const = default;
+};
+
+template <> struct std::hash<Point>
+{
+    size_t operator()(const Point& p) const
+    {
+        return std::hash<int>{}(p.x) * 31 + std::hash<int>{}(p.y);
+    }
+};
+
+// compares only the last digit, so 3 and 13 are the same key.
+struct LastDigitEqual
+{
+    bool operator()(int a, int b) const
+    {
+        return a % 10 == b % 10;
+    }
+};
+
+struct LastDigitHash
+{
+    hash_t operator()(int a) const
+    {
+        return hash_integral(a % 10);
+    }
+};
+
+TEST_CASE("OSet hashes strings and user types")
+{
+    nmg::OSet<std::string> strings;
+    REQUIRE(strings.add("alpha"));
+    REQUIRE(strings.add("beta"));
+    REQUIRE(!strings.add(std::string("alpha")));
+    REQUIRE(strings.contains("beta"));
+    REQUIRE(!strings.contains("gamma"));
+
+    nmg::OSet<Point> points;
+    for(int i = 0; i < 100; ++i)
+    {
+        REQUIRE(points.add(Point{i, -i}));
+    }
+    REQUIRE(points.contains(Point{42, -42}));
+    REQUIRE(!points.contains(Point{42, 42}));
+}
+
+TEST_CASE("OSet uses the given Hash and KeyEqual")
+{
+    nmg::OSet<int, LastDigitHash, LastDigitEqual> oset;
+
+    for(int i = 0; i < 100; ++i)
+    {
+        oset.add(i);
+    }
+    REQUIRE(oset.size() == 10);
+    REQUIRE(oset.contains(1234));
+    REQUIRE(*oset.rbegin() == 9);
+}
+
+TEST_CASE("hash_string reads every byte of strings of any length")
+{
+    std::set<hash_t> hashes;
+    std::string text;
+    for(int len = 0; len < 200; ++len)
+    {
+        REQUIRE(hash_string(text) == hash_string(std::string_view(text)));
+        REQUIRE(hashes.insert(hash_string(text)).second);
+
+        // flipping any single byte changes the hash.
+        for(int i = 0; i < len; ++i)
+        {
+            std::string flipped = text;
+            flipped[i] ^= 1;
+            REQUIRE(hash_string(flipped) != hash_string(text));
+        }
+        text.push_back(static_cast<char>('a' + len % 26));
+    }
+
+    // only the bytes of the view are hashed, not what follows them.
+    std::string longer = "https://example.com/path";
+    REQUIRE(hash_string(std::string_view(longer).substr(0, 19)) == hash_string("https://example.com"));
+}
+
+TEST_CASE("OSet of strings and string_views uses hash_string")
+{
+    REQUIRE(nmg::hasher<std::string>{}("url") == hash_string("url"));
+    REQUIRE(nmg::hasher<std::string_view>{}("url") == hash_string("url"));
+
+    nmg::OSet<std::string> urls;
+    std::vector<std::string> added;
+    for(int i = 0; i < 5000; ++i)
+    {
+        added.push_back("https://example.com/page/" + std::to_string(i));
+        REQUIRE(urls.add(added.back()));
+    }
+    REQUIRE(!urls.add("https://example.com/page/42"));
+
+    nmg::OSet<std::string_view> views;
+    for(const std::string& url : added)
+    {
+        REQUIRE(views.add(url));
+    }
+    REQUIRE(views.size() == urls.size());
+    REQUIRE(views.contains(std::string_view("https://example.com/page/4999")));
+
+    size_t i = 0;
+    for(std::string_view view : views)
+    {
+        REQUIRE(view == added[i++]);
+    }
+}
+
+// records what type of key each lookup hashed.
+struct ViewOnlyHash
+{
+    using is_transparent = void;
+
+    inline static int stringsHashed = 0;
+
+    hash_t operator()(std::string_view str) const
+    {
+        return hash_string(str);
+    }
+
+    hash_t operator()(const std::string& str) const
+    {
+        ++stringsHashed;
+        return hash_string(str);
+    }
+};
+
+TEST_CASE("OSet of strings is searched without constructing strings")
+{
+    nmg::OSet<std::string> strings;
+    strings.add("alpha");
+    strings.add("beta");
+    strings.add("gamma");
+
+    std::string_view beta = "beta";
+    REQUIRE(strings.contains(beta));
+    REQUIRE(strings.contains("gamma"));
+    REQUIRE(!strings.contains(std::string_view("delta")));
+    REQUIRE(*strings.find(beta) == "beta");
+    REQUIRE(strings.find("delta") == strings.end());
+
+    const nmg::OSet<std::string>& constStrings = strings;
+    REQUIRE(*constStrings.find(std::string("alpha")) == "alpha");
+    REQUIRE(constStrings.find(beta) != constStrings.cend());
+
+    REQUIRE(strings.remove(beta));
+    REQUIRE(!strings.remove("beta"));
+    REQUIRE(strings.size() == 2);
+    REQUIRE(*strings.begin() == "alpha");
+
+    nmg::OSet<std::string, ViewOnlyHash, std::equal_to<>> counted;
+    counted.add("alpha");
+    ViewOnlyHash::stringsHashed = 0;
+    REQUIRE(counted.contains(std::string_view("alpha")));
+    REQUIRE(counted.find(std::string_view("alpha")) != counted.end());
+    REQUIRE(counted.remove(std::string_view("alpha")));
+    REQUIRE(ViewOnlyHash::stringsHashed == 0);
+}
+
+TEST_CASE("OSet finds items among those being rehashed")
+{
+    PolicySet<int, IncrementalPolicy> oset;
+    for(int i = 0; i < 1000; ++i)
+    {
+        oset.add(i);
+        REQUIRE(oset.find(i / 2) != oset.end());
+        REQUIRE(*oset.find(i / 2) == i / 2);
+        REQUIRE(oset.find(i + 1) == oset.end());
+    }
+}
+
+TEST_CASE("OSet moves and emplaces items without copying them")
+{
+    gset oset;
+    oset.reserve(10);
+    gint::changes();
+
+    // a moved in item is constructed once more, by the move.
+    REQUIRE(oset.add(gint(1)));
+    REQUIRE(gint::changes().increments == 2);
+
+    gint two(2);
+    gint::changes();
+    REQUIRE(oset.add(std::move(two)));
+    REQUIRE(gint::changes().increments == 1);
+
+    REQUIRE(oset.emplace(3));
+    REQUIRE(gint::changes().increments == 2);
+
+    gint three(3);
+    gint::changes();
+    REQUIRE(!oset.emplace(three));
+    REQUIRE(!oset.try_emplace(three));
+    REQUIRE(!oset.add(std::move(three)));
+    REQUIRE(gint::changes().increments == 0);
+    REQUIRE(three == 3);
+
+    gint four(4);
+    gint::changes();
+    REQUIRE(oset.try_emplace(four));
+    REQUIRE(gint::changes().increments == 1);
+
+    REQUIRE(oset.size() == 4);
+    int expected = 1;
+    for(auto it = oset.cbegin(); it != oset.cend(); ++it)
+    {
+        REQUIRE(*it == expected++);
+    }
+}
+
+TEST_CASE("OSet try_emplace constructs from a transparent key only when it is missing")
+{
+    nmg::OSet<std::string> strings;
+    REQUIRE(strings.try_emplace(std::string_view("alpha")));
+    REQUIRE(strings.try_emplace("beta"));
+    REQUIRE(!strings.try_emplace(std::string_view("alpha")));
+    REQUIRE(strings.try_emplace("gamma", 3));
+    REQUIRE(strings.emplace(3, 'x'));
+    REQUIRE(!strings.emplace("xxx"));
+
+    std::vector<std::string> expected = {"alpha", "beta", "gam", "xxx"};
+    REQUIRE(strings.size() == expected.size());
+    size_t i = 0;
+    for(const std::string& str : strings)
+    {
+        REQUIRE(str == expected[i++]);
+    }
+}
+
+TEST_CASE("OSet holds move-only items")
+{
+    nmg::OSet<std::unique_ptr<int>> pointers;
+    std::vector<int*> raw;
+    for(int i = 0; i < 100; ++i)
+    {
+        auto pointer = std::make_unique<int>(i);
+        raw.push_back(pointer.get());
+        REQUIRE(pointers.add(std::move(pointer)));
+        REQUIRE(pointer == nullptr);
+    }
+    REQUIRE(pointers.emplace(new int(100)));
+
+    REQUIRE(pointers.find(std::unique_ptr<int>()) == pointers.end());
+    pointers.shrink_to_fit();
+
+    int expected = 0;
+    for(const std::unique_ptr<int>& pointer : pointers)
+    {
+        REQUIRE(*pointer == expected++);
+    }
+    REQUIRE(expected == 101);
+
+    nmg::OSet<std::unique_ptr<int>> moved(std::move(pointers));
+    REQUIRE(moved.size() == 101);
+    REQUIRE(*moved.begin()->get() == 0);
+    REQUIRE(moved.begin()->get() == raw[0]);
+}
+
+TEST_CASE("OSet adds ranges in first occurrence order")
+{
+    std::vector<int> numbers = generate_testdata(5000);
+    std::vector<int> withDuplicates = numbers;
+    withDuplicates.insert(withDuplicates.end(), numbers.rbegin(), numbers.rend());
+
+    nmg::OSet<int> oset(withDuplicates.begin(), withDuplicates.end());
+    REQUIRE(oset.size() == numbers.size());
+    REQUIRE(std::equal(oset.begin(), oset.end(), numbers.begin(), numbers.end()));
+
+    // sized once for the whole range, so no later growth was needed.
+    nmg::OSet<int> presized;
+    presized.reserve(withDuplicates.size());
+    REQUIRE(oset.capacity() == presized.capacity());
+
+    REQUIRE(oset.add_range(numbers.begin(), numbers.end()) == 0);
+    std::vector<int> more = {-1, numbers[0], -2, -1};
+    REQUIRE(oset.add_range(more.begin(), more.end()) == 2);
+    REQUIRE(*oset.rbegin() == -2);
+
+    nmg::OSet<std::string> strings = {"beta", "alpha", "beta", "gamma"};
+    std::vector<std::string> expected = {"beta", "alpha", "gamma"};
+    REQUIRE(std::equal(strings.begin(), strings.end(), expected.begin(), expected.end()));
+
+    // items of another type, from a single pass range.
+    std::istringstream words("one two one three");
+    nmg::OSet<std::string> fromStream{std::istream_iterator<std::string>(words), std::istream_iterator<std::string>()};
+    REQUIRE(fromStream.size() == 3);
+    REQUIRE(*fromStream.rbegin() == "three");
+
+    std::vector<const char*> literals = {"x", "y", "x"};
+    REQUIRE(strings.add_range(literals.begin(), literals.end()) == 2);
+
+    // a forward range of another type is sized for up front as well.
+    std::vector<std::string> names;
+    for(int i = 0; i < 3000; ++i)
+    {
+        names.push_back("name" + std::to_string(i));
+    }
+    std::vector<const char*> pointers;
+    for(const std::string& name : names)
+    {
+        pointers.push_back(name.c_str());
+    }
+    CountingResource grown;
+    CountingResource reserved;
+    nmg::pmr::OSet<std::string> converted(&grown);
+    REQUIRE(converted.add_range(pointers.begin(), pointers.end()) == names.size());
+    nmg::pmr::OSet<std::string> presizedStrings(&reserved);
+    presizedStrings.reserve(pointers.size());
+    REQUIRE(grown.allocations == reserved.allocations);
+    REQUIRE(std::equal(converted.begin(), converted.end(), names.begin(), names.end()));
+}
+
+TEST_CASE("OSet moves in ranges of move-only items")
+{
+    std::vector<std::unique_ptr<int>> pointers;
+    for(int i = 0; i < 100; ++i)
+    {
+        pointers.push_back(std::make_unique<int>(i));
+    }
+
+    nmg::OSet<std::unique_ptr<int>> oset(std::make_move_iterator(pointers.begin()),
+                                         std::make_move_iterator(pointers.end()));
+    REQUIRE(oset.size() == 100);
+    REQUIRE(pointers[99] == nullptr);
+    REQUIRE(**oset.rbegin() == 99);
+}
+
+TEST_CASE("OSet contains_many agrees with contains")
+{
+    std::vector<int> numbers = generate_testdata(3000);
+    std::vector<int> keys = numbers;
+    keys.push_back(-1);
+    std::unique_ptr<bool[]> found(new bool[keys.size()]);
+
+    // checked every so often, during and between incremental rehashes.
+    PolicySet<int, IncrementalPolicy> oset;
+    bool sawRehash = false;
+    for(size_t i = 0; i < numbers.size(); i += 2)
+    {
+        oset.add(numbers[i]);
+        if(i % 194 != 0)
+        {
+            continue;
+        }
+
+        sawRehash |= oset.rehashing();
+        size_t count = oset.contains_many(keys, std::span<bool>(found.get(), keys.size()));
+        REQUIRE(count == oset.size());
+        for(size_t k = 0; k < keys.size(); ++k)
+        {
+            REQUIRE(found[k] == oset.contains(keys[k]));
+        }
+    }
+    REQUIRE(sawRehash);
+
+    REQUIRE_THROWS_AS(oset.contains_many(keys, std::span<bool>(found.get(), 1)), std::invalid_argument);
+
+    nmg::OSet<int> empty;
+    REQUIRE(empty.contains_many(keys, std::span<bool>(found.get(), keys.size())) == 0);
+    REQUIRE(!found[0]);
+}
+
+TEST_CASE("OSet erases through iterators without hashing")
+{
+    nmg::OSet<HashCounted, CountingHash> oset;
+    for(int i = 0; i < 100; ++i)
+    {
+        oset.add(HashCounted{i});
+    }
+
+    // look up, inspect, then erase, hashing once.
+    HashCounted::hashes = 0;
+    auto it = oset.find(HashCounted{10});
+    REQUIRE(it->value == 10);
+    it = oset.erase(it);
+    REQUIRE(it->value == 11);
+    REQUIRE(HashCounted::hashes == 1);
+    REQUIRE(!oset.contains(HashCounted{10}));
+
+    // every other item, walking forwards.
+    HashCounted::hashes = 0;
+    for(auto pos = oset.begin(); pos != oset.end();)
+    {
+        if(pos->value % 2 == 0)
+        {
+            pos = oset.erase(pos);
+        }
+        else
+        {
+            ++pos;
+        }
+    }
+    REQUIRE(HashCounted::hashes == 0);
+    REQUIRE(oset.size() == 50);
+    REQUIRE(oset.begin()->value == 1);
+
+    // a range, walking backwards from the end.
+    auto last = oset.rbegin();
+    for(int i = 0; i < 10; ++i)
+    {
+        ++last;
+    }
+    REQUIRE(oset.erase(oset.rbegin(), last) == last);
+    REQUIRE(oset.size() == 40);
+    REQUIRE(oset.rbegin()->value == 79);
+
+    const nmg::OSet<HashCounted, CountingHash>& constSet = oset;
+    REQUIRE(oset.erase(constSet.cbegin())->value == 3);
+    REQUIRE_THROWS_AS(oset.erase(oset.end()), std::out_of_range);
+
+    REQUIRE(oset.erase(oset.begin(), oset.end()) == oset.end());
+    REQUIRE(oset.empty());
+    REQUIRE(HashCounted::hashes == 0);
+}
+
+TEST_CASE("OSet erases through iterators while rehashing")
+{
+    PolicySet<std::string, IncrementalPolicy> oset;
+    for(int i = 0; i < 1000; ++i)
+    {
+        oset.add(std::to_string(i));
+        if(i % 3 == 0 && oset.rehashing())
+        {
+            oset.erase(oset.find(std::to_string(i / 2)));
+        }
+    }
+    for(int i = 0; i < 1000; ++i)
+    {
+        auto it = oset.find(std::to_string(i));
+        if(it != oset.end())
+        {
+            oset.erase(it);
+        }
+    }
+    REQUIRE(oset.empty());
+}
+
+// checks that a set holds the items of a list, in the same order.
+template <typename Set> static bool same_order(const Set& oset, const std::list<int>& expected)
+{
+    auto it = oset.cbegin();
+    for(int item : expected)
+    {
+        if(it == oset.cend() || *it != item)
+        {
+            return false;
+        }
+        ++it;
+    }
+    return it == oset.cend() && oset.size() == expected.size();
+}
+
+TEST_CASE("OSet moves items to the back and front")
+{
+    nmg::OSet<int> oset = {1, 2, 3, 4, 5};
+
+    REQUIRE(oset.move_to_back(2));
+    REQUIRE(same_order(oset, {1, 3, 4, 5, 2}));
+    REQUIRE(oset.move_to_front(4));
+    REQUIRE(same_order(oset, {4, 1, 3, 5, 2}));
+    REQUIRE(oset.move_to_front(4));
+    REQUIRE(oset.move_to_back(2));
+    REQUIRE(same_order(oset, {4, 1, 3, 5, 2}));
+    REQUIRE(!oset.move_to_back(6));
+    REQUIRE(!oset.move_to_front(6));
+
+    auto it = oset.move_to_back(oset.find(1));
+    REQUIRE(*it == 1);
+    REQUIRE(++it == oset.end());
+    it = oset.move_to_front(oset.find(5));
+    REQUIRE(it == oset.begin());
+    REQUIRE(same_order(oset, {5, 4, 3, 2, 1}));
+    REQUIRE(*oset.rbegin() == 1);
+    REQUIRE_THROWS_AS(oset.move_to_back(oset.end()), std::out_of_range);
+
+    oset.remove(5);
+    oset.remove(4);
+    REQUIRE(oset.add(6));
+    REQUIRE(oset.move_to_front(6));
+    REQUIRE(same_order(oset, {6, 3, 2, 1}));
+
+    nmg::OSet<std::string> strings = {"alpha", "beta"};
+    REQUIRE(strings.move_to_back(std::string_view("alpha")));
+    REQUIRE(strings.move_to_front("beta"));
+    REQUIRE(*strings.rbegin() == "alpha");
+}
+
+TEST_CASE("OSet keeps order under random moves, adds and removes")
+{
+    std::uniform_int_distribution<int> keys(0, 299);
+    std::uniform_int_distribution<int> ops(0, 9);
+
+    gint::init();
+    PolicySet<int, IncrementalPolicy> oset;
+    nmg::OSet<gint> grave;
+    std::list<int> expected;
+    for(int step = 0; step < 20000; ++step)
+    {
+        int key = keys(randomVar);
+        auto found = std::find(expected.begin(), expected.end(), key);
+        int op = ops(randomVar);
+        bool present = found != expected.end();
+
+        if(op < 3)
+        {
+            REQUIRE(oset.add(key) == !present);
+            REQUIRE(grave.add(key) == !present);
+            if(!present)
+            {
+                expected.push_back(key);
+            }
+        }
+        else if(op < 4)
+        {
+            REQUIRE(oset.remove(key) == present);
+            REQUIRE(grave.remove(key) == present);
+            if(present)
+            {
+                expected.erase(found);
+            }
+        }
+        else if(op < 7)
+        {
+            REQUIRE(oset.move_to_back(key) == present);
+            REQUIRE(grave.move_to_back(key) == present);
+            if(present)
+            {
+                expected.splice(expected.end(), expected, found);
+            }
+        }
+        else
+        {
+            REQUIRE(oset.move_to_front(key) == present);
+            REQUIRE(grave.move_to_front(key) == present);
+            if(present)
+            {
+                expected.splice(expected.begin(), expected, found);
+            }
+        }
+
+        if(step % 97 == 0)
+        {
+            REQUIRE(same_order(oset, expected));
+            REQUIRE(same_order(grave, expected));
+            REQUIRE(*oset.rbegin() == expected.back());
+        }
+    }
+    REQUIRE(same_order(oset, expected));
+    REQUIRE(gint::count() == static_cast<int>(grave.size()));
+}
+
+// an item that counts how often it is moved.
+struct MoveCounted
+{
+    int value;
+    static inline int moves = 0;
+
+    MoveCounted(int value)
+        : value(value)
+    {
+    }
+
+    MoveCounted(MoveCounted&& other) noexcept
+        : value(other.value)
+    {
+        ++moves;
+    }
+
+    bool operator==(const MoveCounted& other) const
+    {
+        return value == other.value;
+    }
+};
+
+struct MoveCountedHash
+{
+    hash_t operator()(const MoveCounted& obj) const
+    {
+        return hash_integral(obj.value);
+    }
+};
+
+TEST_CASE("OSet grows and compacts its store a few items per add with a rehash budget")
+{
+    CountingResource resource;
+    nmg::pmr::OSet<MoveCounted, MoveCountedHash, std::equal_to<MoveCounted>, IncrementalPolicy> oset(&resource);
+    std::list<int> expected;
+
+    int most = 0;
+    auto add = [&](int value) {
+        MoveCounted item(value);
+        MoveCounted::moves = 0;
+        REQUIRE(oset.add(std::move(item)));
+        most = std::max(most, MoveCounted::moves);
+        expected.push_back(value);
+    };
+
+    const int size = 50000;
+    for(int i = 0; i < size; ++i)
+    {
+        add(i);
+    }
+
+    // churn at the front and just behind the back leaves dead entries
+    // throughout the store, which is recycled rather than grown for good.
+    size_t settled = 0;
+    for(int i = size; i < 4 * size; ++i)
+    {
+        if(i == 3 * size)
+        {
+            settled = resource.outstanding;
+        }
+        add(i);
+        if(i % 2 == 0)
+        {
+            REQUIRE(oset.remove(MoveCounted(expected.front())));
+            expected.pop_front();
+        }
+        else
+        {
+            auto recent = std::find(expected.rbegin(), expected.rend(), i - 7);
+            REQUIRE(oset.remove(MoveCounted(*recent)));
+            expected.erase(std::next(recent).base());
+        }
+
+        if(i % 9973 == 0)
+        {
+            REQUIRE(same_order(oset, expected));
+            REQUIRE(*oset.nth(size / 2) == *std::next(expected.begin(), size / 2));
+        }
+    }
+
+    // the add itself moves the item in, the rest is growth and compaction.
+    REQUIRE(most <= 3 * static_cast<int>(IncrementalPolicy::rehash_budget));
+    REQUIRE(same_order(oset, expected));
+    REQUIRE(resource.outstanding <= settled);
+}
+
+TEST_CASE("OSet find_or_emplace finds or adds with one lookup")
+{
+    nmg::OSet<std::string> strings = {"alpha"};
+
+    auto [found, added] = strings.find_or_emplace(std::string_view("alpha"), "unused");
+    REQUIRE(!added);
+    REQUIRE(found == strings.begin());
+
+    auto [inserted, addedNew] = strings.find_or_emplace(std::string_view("beta"), "beta");
+    REQUIRE(addedNew);
+    REQUIRE(*inserted == "beta");
+    REQUIRE(strings.size() == 2);
+}
+
+TEST_CASE("OSet index_of and nth agree with the order")
+{
+    std::uniform_int_distribution<int> keys(0, 999);
+    std::uniform_int_distribution<int> ops(0, 9);
+
+    nmg::OSet<int> oset;
+    std::vector<int> expected;
+    for(int step = 0; step < 20000; ++step)
+    {
+        int key = keys(randomVar);
+        auto found = std::find(expected.begin(), expected.end(), key);
+        int op = ops(randomVar);
+
+        if(op < 5)
+        {
+            if(oset.add(key))
+            {
+                expected.push_back(key);
+            }
+        }
+        else if(op < 7)
+        {
+            if(oset.remove(key))
+            {
+                expected.erase(found);
+            }
+        }
+        else if(op < 8)
+        {
+            if(oset.move_to_back(key))
+            {
+                expected.erase(found);
+                expected.push_back(key);
+            }
+        }
+        else if(op < 9)
+        {
+            if(oset.move_to_front(key))
+            {
+                expected.erase(found);
+                expected.insert(expected.begin(), key);
+            }
+        }
+        else
+        {
+            size_t index = found - expected.begin();
+            REQUIRE(oset.index_of(key) == (found == expected.end() ? nmg::NPOS : index));
+            if(!expected.empty())
+            {
+                size_t nth = static_cast<size_t>(key) % expected.size();
+                REQUIRE(*oset.nth(nth) == expected[nth]);
+            }
+        }
+    }
+
+    for(size_t i = 0; i < expected.size(); ++i)
+    {
+        REQUIRE(oset.index_of(expected[i]) == i);
+        REQUIRE(*oset.nth(i) == expected[i]);
+    }
+    REQUIRE(oset.nth(expected.size()) == oset.end());
+
+    nmg::OSet<std::string> strings = {"alpha", "beta", "gamma"};
+    strings.remove("alpha");
+    REQUIRE(strings.index_of(std::string_view("gamma")) == 1);
+    REQUIRE(*strings.nth(0) == "beta");
+}
+
+TEST_CASE("OSet index_of and nth are read through a const reference")
+{
+    nmg::OSet<int> oset;
+    for(int i = 0; i < 100; ++i)
+    {
+        oset.add(i);
+    }
+    for(int i = 0; i < 100; i += 3)
+    {
+        oset.remove(i);
+    }
+
+    // the removals leave dead entries, so the first query builds the rank tree.
+    const nmg::OSet<int>& view = oset;
+    size_t index = 0;
+    for(int i = 0; i < 100; ++i)
+    {
+        if(i % 3 == 0)
+        {
+            REQUIRE(view.index_of(i) == nmg::NPOS);
+            continue;
+        }
+        REQUIRE(view.index_of(i) == index);
+        nmg::OSet<int>::const_iterator it = view.nth(index);
+        REQUIRE(*it == i);
+        ++index;
+    }
+    REQUIRE(view.nth(index) == view.cend());
+
+    const nmg::OSet<std::string> strings = {"alpha", "beta", "gamma"};
+    REQUIRE(strings.index_of(std::string_view("gamma")) == 2);
+    REQUIRE(*strings.nth(1) == "beta");
+}
+
+// the items of a set, in order.
+template <typename Set> static std::vector<int> ordered(const Set& oset)
+{
+    std::vector<int> items;
+    for(auto it = oset.cbegin(); it != oset.cend(); ++it)
+    {
+        items.push_back(*it);
+    }
+    return items;
+}
+
+TEST_CASE("OSet set algebra keeps left then right order")
+{
+    nmg::OSet<int> left = {5, 1, 4, 2, 3};
+    nmg::OSet<int> right = {6, 3, 7, 1};
+
+    REQUIRE(ordered(nmg::set_union(left, right)) == std::vector<int>{5, 1, 4, 2, 3, 6, 7});
+    REQUIRE(ordered(nmg::set_intersection(left, right)) == std::vector<int>{1, 3});
+    REQUIRE(ordered(nmg::set_intersection(right, left)) == std::vector<int>{3, 1});
+    REQUIRE(ordered(nmg::set_difference(left, right)) == std::vector<int>{5, 4, 2});
+    REQUIRE(ordered(nmg::set_symmetric_difference(left, right)) == std::vector<int>{5, 4, 2, 6, 7});
+
+    nmg::OSet<int> copy = left;
+    REQUIRE(ordered(copy.set_union(right)) == std::vector<int>{5, 1, 4, 2, 3, 6, 7});
+    copy = left;
+    REQUIRE(ordered(copy.set_intersection(right)) == std::vector<int>{1, 3});
+    copy = right;
+    REQUIRE(ordered(copy.set_intersection(left)) == std::vector<int>{3, 1});
+    copy = left;
+    REQUIRE(ordered(copy.set_difference(right)) == std::vector<int>{5, 4, 2});
+    copy = right;
+    REQUIRE(ordered(copy.set_difference(left)) == std::vector<int>{6, 7});
+    copy = left;
+    REQUIRE(ordered(copy.set_symmetric_difference(right)) == std::vector<int>{5, 4, 2, 6, 7});
+
+    // with itself.
+    copy = left;
+    REQUIRE(copy.set_union(copy).size() == 5);
+    REQUIRE(copy.set_intersection(copy).size() == 5);
+    REQUIRE(copy.set_difference(copy).empty());
+    copy = left;
+    REQUIRE(copy.set_symmetric_difference(copy).empty());
+
+    nmg::OSet<int> empty;
+    REQUIRE(nmg::set_intersection(left, empty).empty());
+    REQUIRE(ordered(nmg::set_difference(left, empty)) == ordered(left));
+    REQUIRE(ordered(empty.set_union(left)) == ordered(left));
+}
+
+TEST_CASE("OSet set algebra matches std::set on large sets")
+{
+    std::vector<int> numbers = generate_testdata(20000);
+    std::shuffle(numbers.begin(), numbers.end(), randomVar);
+
+    // overlapping halves of different sizes, with some removals.
+    nmg::OSet<std::string> left;
+    nmg::OSet<std::string> right;
+    for(size_t i = 0; i < numbers.size(); ++i)
+    {
+        if(i < 14000)
+        {
+            left.add(std::to_string(numbers[i]));
+        }
+        if(i >= 10000)
+        {
+            right.add(std::to_string(numbers[i]));
+        }
+    }
+    for(size_t i = 0; i < numbers.size(); i += 7)
+    {
+        left.remove(std::to_string(numbers[i]));
+    }
+
+    auto check = [&](const nmg::OSet<std::string>& result, bool inLeftOnly, bool inBoth, bool inRightOnly) {
+        std::vector<std::string> expected;
+        for(const std::string& item : left)
+        {
+            if(right.contains(item) ? inBoth : inLeftOnly)
+            {
+                expected.push_back(item);
+            }
+        }
+        for(const std::string& item : right)
+        {
+            if(!left.contains(item) && inRightOnly)
+            {
+                expected.push_back(item);
+            }
+        }
+        return std::equal(result.cbegin(), result.cend(), expected.begin(), expected.end()) &&
+               result.size() == expected.size();
+    };
+
+    REQUIRE(check(nmg::set_union(left, right), true, true, true));
+    REQUIRE(check(nmg::set_intersection(left, right), false, true, false));
+    REQUIRE(check(nmg::set_difference(left, right), true, false, false));
+    REQUIRE(check(nmg::set_symmetric_difference(left, right), true, false, true));
+
+    nmg::OSet<std::string> copy = left;
+    REQUIRE(check(copy.set_intersection(right), false, true, false));
+    copy = left;
+    REQUIRE(check(copy.set_difference(right), true, false, false));
+    copy = left;
+    REQUIRE(check(copy.set_symmetric_difference(right), true, false, true));
+}
+
+TEST_CASE("OSet extract and insert move items between sets")
+{
+    using ptr = std::unique_ptr<int>;
+    nmg::OSet<ptr> from;
+    nmg::OSet<ptr> to;
+    std::vector<int*> raw;
+    for(int i = 0; i < 10; ++i)
+    {
+        ptr item = std::make_unique<int>(i);
+        raw.push_back(item.get());
+        from.add(std::move(item));
+    }
+
+    // move-only items can only get across by being moved.
+    auto node = from.extract(from.nth(3));
+    REQUIRE(node);
+    REQUIRE(node.value().get() == raw[3]);
+    REQUIRE(from.size() == 9);
+    REQUIRE(!from.contains(node.value()));
+
+    auto [it, added] = to.insert(std::move(node));
+    REQUIRE(added);
+    REQUIRE(node.empty());
+    REQUIRE(it->get() == raw[3]);
+    REQUIRE(to.size() == 1);
+
+    // an empty node inserts nothing.
+    auto [endIt, emptyAdded] = to.insert(std::move(node));
+    REQUIRE(!emptyAdded);
+    REQUIRE(endIt == to.end());
+
+    nmg::OSet<std::string> names = {"alpha", "beta", "gamma"};
+    auto missing = names.extract(std::string("delta"));
+    REQUIRE(missing.empty());
+    auto beta = names.extract(std::string_view("beta"));
+    REQUIRE(beta.value() == "beta");
+    REQUIRE(names.size() == 2);
+
+    // an item already present is left in the node.
+    names.add("beta");
+    auto [present, betaAdded] = names.insert(std::move(beta));
+    REQUIRE(!betaAdded);
+    REQUIRE(*present == "beta");
+    REQUIRE(beta.value() == "beta");
+
+    REQUIRE_THROWS_AS(names.extract(names.end()), std::out_of_range);
+}
+
+TEST_CASE("OSet merge moves only the missing items")
+{
+    nmg::OSet<std::string> into = {"a", "b", "c"};
+    nmg::OSet<std::string> from = {"d", "b", "e", "a", "f"};
+    into.merge(from);
+    std::vector<std::string> merged = {"a", "b", "c", "d", "e", "f"};
+    std::vector<std::string> left = {"b", "a"};
+    REQUIRE(std::equal(into.cbegin(), into.cend(), merged.begin(), merged.end()));
+    REQUIRE(std::equal(from.cbegin(), from.cend(), left.begin(), left.end()));
+    REQUIRE(from.find("b") != from.end());
+    REQUIRE(!from.contains("d"));
+
+    // disjoint sets move everything across, and empty the source.
+    nmg::OSet<std::string> rest = {"x", "y"};
+    into.merge(rest);
+    REQUIRE(rest.empty());
+    REQUIRE(into.size() == 8);
+    into.merge(into);
+    REQUIRE(into.size() == 8);
+
+    // both sets stay usable, also while rehashing incrementally.
+    std::vector<int> numbers = generate_testdata(5000);
+    nmg::OSet<int> evens;
+    nmg::OSet<int> all;
+    all.rehash_budget(4);
+    for(int number : numbers)
+    {
+        all.add(number);
+        if(number % 2 == 0)
+        {
+            evens.add(number);
+        }
+    }
+    size_t evenCount = evens.size();
+    nmg::OSet<int> others = all;
+    others.merge(evens);
+    REQUIRE(evens.size() == evenCount);
+    REQUIRE(others.size() == all.size());
+
+    evens.merge(others);
+    REQUIRE(evens.size() == all.size());
+    REQUIRE(others.size() == evenCount);
+    for(int number : numbers)
+    {
+        REQUIRE(others.contains(number) == (number % 2 == 0));
+        REQUIRE(evens.remove(number));
+    }
+    REQUIRE(evens.empty());
+}
+
+struct SmallPolicy : nmg::DefaultPolicy
+{
+    static constexpr size_t small_size = 8;
+};
+
+TEST_CASE("OSet small sets have no table until they outgrow the small size")
+{
+    PolicySet<int, SmallPolicy> oset;
+    for(int i = 0; i < 8; ++i)
+    {
+        REQUIRE(oset.add(i * 3));
+        REQUIRE(!oset.add(i * 3));
+        REQUIRE(oset.capacity() == 0);
+    }
+    for(int i = 0; i < 24; ++i)
+    {
+        REQUIRE(oset.contains(i) == (i % 3 == 0));
+    }
+
+    // removals, moves and erases work on the store alone.
+    REQUIRE(oset.remove(6));
+    REQUIRE(!oset.remove(6));
+    REQUIRE(oset.move_to_front(21));
+    REQUIRE(oset.move_to_back(0));
+    oset.erase(oset.find(9));
+    REQUIRE(same_order(oset, {21, 3, 12, 15, 18, 0}));
+    REQUIRE(oset.index_of(15) == 3);
+    REQUIRE(*oset.nth(4) == 18);
+    REQUIRE(oset.extract(12).value() == 12);
+    REQUIRE(oset.capacity() == 0);
+
+    // growing past the small size builds the table over the items in place.
+    for(int i = 100; i < 104; ++i)
+    {
+        oset.add(i);
+    }
+    REQUIRE(oset.capacity() > 0);
+    REQUIRE(same_order(oset, {21, 3, 15, 18, 0, 100, 101, 102, 103}));
+    REQUIRE(oset.contains(103));
+    REQUIRE(!oset.contains(12));
+
+    // and shrinking back within it drops the table again.
+    oset.remove(100);
+    oset.remove(101);
+    oset.shrink_to_fit();
+    REQUIRE(oset.capacity() == 0);
+    REQUIRE(same_order(oset, {21, 3, 15, 18, 0, 102, 103}));
+    REQUIRE(oset.contains(102));
+
+    PolicySet<int, SmallPolicy> presized;
+    presized.reserve(8);
+    REQUIRE(presized.capacity() == 0);
+    presized.reserve(9);
+    REQUIRE(presized.capacity() > 0);
+}
+
+TEST_CASE("OSet keeps the state most sets never need out of the object")
+{
+    // a table, a store and one pointer to the rest; a small set adds the
+    // room for its entries.
+    using Set = nmg::OSet<int>;
+    size_t core = sizeof(Set::Table_t) + sizeof(Set::Store_t) + sizeof(void*);
+    REQUIRE(sizeof(Set) == core);
+    REQUIRE(sizeof(PolicySet<int, IncrementalPolicy>) == core);
+    REQUIRE(sizeof(PolicySet<int, SmallPolicy>) <= core + sizeof(nmg::InlineEntries<int, SmallPolicy::small_size>));
+
+    // tuning is kept there too, and carried over by copies and moves.
+    Set tuned;
+    tuned.max_load_factor(0.5f);
+    tuned.growth_factor(3.0f);
+    tuned.min_capacity(64);
+    tuned.rehash_budget(2);
+    for(int i = 0; i < 1000; ++i)
+    {
+        tuned.add(i);
+    }
+    Set copy(tuned);
+    REQUIRE(copy.max_load_factor() == 0.5f);
+    REQUIRE(copy.growth_factor() == 3.0f);
+    REQUIRE(copy.min_capacity() == 64);
+    REQUIRE(copy.rehash_budget() == 2);
+    REQUIRE(std::equal(copy.begin(), copy.end(), tuned.begin(), tuned.end()));
+
+    Set moved(std::move(copy));
+    REQUIRE(moved.rehash_budget() == 2);
+    REQUIRE(moved.size() == 1000);
+
+    // assigning an untuned set takes the policy values back.
+    Set plain = {1, 2, 3};
+    moved = plain;
+    REQUIRE(moved.max_load_factor() == nmg::DefaultPolicy::max_load_factor);
+    REQUIRE(moved.rehash_budget() == 0);
+    tuned = std::move(plain);
+    REQUIRE(tuned.min_capacity() == nmg::DefaultPolicy::min_capacity);
+    REQUIRE(same_order(tuned, {1, 2, 3}));
+}
+
+TEST_CASE("OSet small sets match std::set under churn")
+{
+    PolicySet<std::string, SmallPolicy> strings;
+    PolicySet<int, SmallPolicy> ints;
+    std::set<int> model;
+    std::uniform_int_distribution<int> pick(0, 15);
+
+    for(int step = 0; step < 5000; ++step)
+    {
+        int value = pick(randomVar);
+        bool present = model.count(value) != 0;
+        switch(pick(randomVar) % 4)
+        {
+        case 0:
+        case 1:
+            REQUIRE(ints.add(value) == !present);
+            REQUIRE(strings.add(std::to_string(value)) == !present);
+            model.insert(value);
+            break;
+        case 2:
+            REQUIRE(ints.remove(value) == present);
+            REQUIRE(strings.remove(std::to_string(value)) == present);
+            model.erase(value);
+            break;
+        default:
+            REQUIRE(ints.move_to_front(value) == present);
+            REQUIRE(strings.move_to_back(std::to_string(value)) == present);
+            break;
+        }
+        if(model.size() <= 4)
+        {
+            ints.shrink_to_fit();
+        }
+
+        REQUIRE(ints.size() == model.size());
+        REQUIRE(strings.size() == model.size());
+        for(int probe = 0; probe < 16; ++probe)
+        {
+            REQUIRE(ints.contains(probe) == (model.count(probe) != 0));
+            REQUIRE(strings.contains(std::to_string(probe)) == (model.count(probe) != 0));
+        }
+    }
+}
+
+TEST_CASE("OSet small sets keep their items inside the object")
+{
+    CountingResource resource;
+    {
+        using Set = nmg::pmr::OSet<std::string, nmg::hasher<std::string>, nmg::default_equal<std::string>, SmallPolicy>;
+        auto item = [](int i) { return std::string(32, 'a') + std::to_string(i); };
+
+        Set oset(&resource);
+        for(int i = 0; i < 8; ++i)
+        {
+            oset.add(item(i));
+        }
+        oset.remove(item(2));
+        oset.move_to_front(item(5));
+        oset.add(item(8));
+        REQUIRE(resource.allocations == 0);
+
+        // copies and moves of a small set stay inside the objects too.
+        Set copy(oset, &resource);
+        Set moved(std::move(copy));
+        Set assigned(&resource);
+        assigned.add(item(99));
+        assigned = std::move(moved);
+        REQUIRE(resource.allocations == 0);
+        REQUIRE(std::equal(assigned.begin(), assigned.end(), oset.begin(), oset.end()));
+        REQUIRE(assigned.contains(item(8)));
+        REQUIRE(!assigned.contains(item(99)));
+
+        // outgrowing the small size moves the entries to the heap.
+        for(int i = 9; i < 20; ++i)
+        {
+            oset.add(item(i));
+        }
+        REQUIRE(resource.allocations > 0);
+        Set large(std::move(oset));
+        REQUIRE(large.index_of(item(19)) == 18);
+
+        // and shrinking back within it takes them inside again.
+        for(int i = 9; i < 20; ++i)
+        {
+            large.remove(item(i));
+        }
+        large.shrink_to_fit();
+        REQUIRE(resource.outstanding == 0);
+        REQUIRE(std::equal(large.begin(), large.end(), assigned.begin(), assigned.end()));
+    }
+    REQUIRE(resource.outstanding == 0);
+}
+
+// an item whose copies and moves throw once a countdown runs out.
+struct Fragile
+{
+    std::string value;
+    static inline int countdown = -1;
+
+    explicit Fragile(int value)
+        : value(std::string(32, 'f') + std::to_string(value))
+    {
+    }
+
+    Fragile(const Fragile& other)
+        : value(other.value)
+    {
+        tick();
+    }
+
+    Fragile(Fragile&& other)
+        : value(std::move(other.value))
+    {
+        tick();
+    }
+
+    bool operator==(const Fragile& other) const
+    {
+        return value == other.value;
+    }
+
+    static void tick()
+    {
+        if(countdown >= 0 && countdown-- == 0)
+        {
+            throw std::runtime_error("fragile");
+        }
+    }
+};
+
+struct FragileHash
+{
+    hash_t operator()(const Fragile& obj) const
+    {
+        return nmg::hasher<std::string>()(obj.value);
+    }
+};
+
+// adds and moves items while copies throw at random, checking the set is
+// left as it was by every operation that throws.
+template <typename Policy> static void check_fragile()
+{
+    nmg::OSet<Fragile, FragileHash, std::equal_to<Fragile>, Policy> oset;
+    std::list<int> expected;
+    std::uniform_int_distribution<int> pick(0, 40);
+    int thrown = 0;
+    for(int i = 0; i < 3000; ++i)
+    {
+        Fragile::countdown = pick(randomVar);
+        try
+        {
+            if(i % 3 == 2)
+            {
+                int value = expected.front();
+                oset.remove(Fragile(value));
+                expected.pop_front();
+            }
+            else if(i % 7 == 0 && !expected.empty())
+            {
+                int value = expected.back();
+                oset.move_to_front(Fragile(value));
+                expected.pop_back();
+                expected.push_front(value);
+            }
+            else
+            {
+                oset.add(Fragile(i));
+                expected.push_back(i);
+            }
+        }
+        catch(const std::runtime_error&)
+        {
+            ++thrown;
+        }
+        Fragile::countdown = -1;
+
+        REQUIRE(oset.size() == expected.size());
+        auto item = expected.begin();
+        for(const Fragile& fragile : oset)
+        {
+            REQUIRE(fragile.value == Fragile(*item++).value);
+        }
+    }
+    REQUIRE(thrown > 0);
+    for(int value : expected)
+    {
+        REQUIRE(oset.contains(Fragile(value)));
+    }
+}
+
+TEST_CASE("OSet is left as it was when an item throws while the store grows")
+{
+    check_fragile<nmg::DefaultPolicy>();
+    check_fragile<IncrementalPolicy>();
+    check_fragile<SmallPolicy>();
+}
+
+struct WideSmallPolicy : nmg::DefaultPolicy
+{
+    static constexpr size_t small_size = 40;
+};
+
+// fills a small set, removes every third item and checks every lookup.
+template <typename Int> static void check_small_scan()
+{
+    PolicySet<Int, WideSmallPolicy> oset;
+    for(int i = 0; i < 40; ++i)
+    {
+        oset.add(static_cast<Int>(i * 3 - 20));
+    }
+    for(int i = 0; i < 40; i += 3)
+    {
+        oset.remove(static_cast<Int>(i * 3 - 20));
+    }
+    REQUIRE(oset.capacity() == 0);
+    for(int value = -25; value < 105; ++value)
+    {
+        bool expected = (value + 20) % 3 == 0 && value >= -20 && value < 100 && (value + 20) / 3 % 3 != 0;
+        REQUIRE(oset.contains(static_cast<Int>(value)) == expected);
+    }
+}
+
+TEST_CASE("OSet small sets scan integral keys of every width")
+{
+    check_small_scan<int8_t>();
+    check_small_scan<uint16_t>();
+    check_small_scan<int>();
+    check_small_scan<long long>();
+}
+
+struct RobinHoodPolicy : nmg::DefaultPolicy
+{
+    template <typename Reduction, typename Index> using table_type = nmg::RobinHoodTable<Reduction, Index>;
+};
+
+// an insertion ordered set of numbers to check a set against, a list in
+// order with a map into it for lookups.
+struct OrderModel
+{
+    std::list<int> order;
+    std::unordered_map<int, std::list<int>::iterator> where;
+
+    bool contains(int value) const
+    {
+        return where.count(value) != 0;
+    }
+
+    bool add(int value)
+    {
+        if(contains(value))
+        {
+            return false;
+        }
+        where[value] = order.insert(order.end(), value);
+        return true;
+    }
+
+    bool remove(int value)
+    {
+        auto found = where.find(value);
+        if(found == where.end())
+        {
+            return false;
+        }
+        order.erase(found->second);
+        where.erase(found);
+        return true;
+    }
+
+    bool move_to_front(int value)
+    {
+        auto found = where.find(value);
+        if(found == where.end())
+        {
+            return false;
+        }
+        order.splice(order.begin(), order, found->second);
+        return true;
+    }
+};
+
+// checks that a set holds the numbers of a model, or their strings, in
+// the same order.
+template <typename Set> static bool same_model_order(const Set& oset, const OrderModel& model)
+{
+    auto it = oset.cbegin();
+    for(int value : model.order)
+    {
+        if(it == oset.cend())
+        {
+            return false;
+        }
+        if constexpr (std::is_same_v<std::remove_cvref_t<decltype(*it)>, std::string>)
+        {
+            if(*it != std::to_string(value))
+            {
+                return false;
+            }
+        }
+        else if(*it != value)
+        {
+            return false;
+        }
+        ++it;
+    }
+    return it == oset.cend() && oset.size() == model.order.size();
+}
+
+TEST_CASE("RobinHoodTable keeps runs sorted by distance and shifts back on erase")
+{
+    std::allocator<int> alloc;
+    nmg::RobinHoodTable<nmg::MaskReduction> table;
+    table.allocate(alloc, 64, 56);
+
+    // few homes, so long runs form and entries are displaced.
+    auto hashOf = [](size_t pos) { return static_cast<hash_t>(pos % 5) << 7; };
+    for(size_t pos = 0; pos < 40; ++pos)
+    {
+        table.place(pos, hashOf(pos));
+    }
+    for(size_t pos = 0; pos < 40; pos += 2)
+    {
+        size_t slot = table.find(hashOf(pos), [&](size_t candidate) { return candidate == pos; });
+        REQUIRE(slot != nmg::NPOS);
+        table.erase(slot);
+    }
+
+    size_t full = 0;
+    for(size_t slot = 0; slot < table._capacity; ++slot)
+    {
+        full += table.is_full(slot);
+        // no holes: each entry is at most one slot further than the one before.
+        size_t prev = slot == 0 ? table._capacity - 1 : slot - 1;
+        auto dist = [&](size_t at) { return decltype(table)::distance(table._meta[at]); };
+        if(dist(slot) > 1)
+        {
+            REQUIRE(dist(prev) + 1 >= dist(slot));
+        }
+    }
+    REQUIRE(full == 20);
+    REQUIRE(table._growthLeft == 56 - 20);
+    for(size_t pos = 0; pos < 40; ++pos)
+    {
+        size_t slot = table.find(hashOf(pos), [&](size_t candidate) { return candidate == pos; });
+        REQUIRE((slot != nmg::NPOS) == (pos % 2 == 1));
+    }
+    table.release(alloc);
+}
+
+TEST_CASE("RobinHoodTable only compares entries with the same tag")
+{
+    std::allocator<int> alloc;
+    nmg::RobinHoodTable<nmg::MaskReduction> table;
+    table.allocate(alloc, 64, 56);
+
+    // one home for all, told apart only by the tag in the low bits.
+    for(size_t pos = 0; pos < 32; ++pos)
+    {
+        table.place(pos, static_cast<hash_t>(pos % 16));
+    }
+
+    size_t compared = 0;
+    auto matches = [&](size_t) {
+        ++compared;
+        return false;
+    };
+    REQUIRE(table.find(3, matches) == nmg::NPOS);
+    REQUIRE(compared == 2);
+
+    compared = 0;
+    REQUIRE(table.find(16, matches) == nmg::NPOS);
+    REQUIRE(compared == 0);
+    REQUIRE(table.first_match(16) == nmg::NPOS);
+
+    size_t slot = table.first_match(5);
+    REQUIRE(slot != nmg::NPOS);
+    REQUIRE(table._slots[slot] % 16 == 5);
+    table.release(alloc);
+}
+
+TEST_CASE("RobinHoodTable caps distances too long to record")
+{
+    std::allocator<int> alloc;
+    nmg::RobinHoodTable<nmg::MaskReduction> table;
+    table.allocate(alloc, 1024, 896);
+
+    // one home for all, so the run outgrows the eight bits of distance.
+    auto hashOf = [](size_t pos) { return static_cast<hash_t>(pos % 3); };
+    auto find = [&](size_t pos) {
+        return table.find(hashOf(pos), [&](size_t candidate) { return candidate == pos; });
+    };
+    size_t fitting = 0;
+    for(size_t pos = 0; pos < 400; ++pos)
+    {
+        fitting += table.place(pos, hashOf(pos));
+    }
+    REQUIRE(fitting < 255);
+    for(size_t pos = 0; pos < 400; ++pos)
+    {
+        REQUIRE(find(pos) != nmg::NPOS);
+    }
+
+    // erasing stops shifting at capped entries, which are still found.
+    for(size_t pos = 0; pos < 400; pos += 4)
+    {
+        table.erase(find(pos));
+    }
+    for(size_t pos = 400; pos < 500; ++pos)
+    {
+        table.place(pos, hashOf(pos));
+    }
+    for(size_t pos = 0; pos < 500; ++pos)
+    {
+        REQUIRE((find(pos) != nmg::NPOS) == (pos >= 400 || pos % 4 != 0));
+    }
+    table.release(alloc);
+}
+
+// every item shares a home, and most share a tag.
+struct CollidingHash
+{
+    hash_t operator()(int value) const
+    {
+        return static_cast<hash_t>(value % 4);
+    }
+};
+
+TEST_CASE("OSet with a Robin Hood table holds runs longer than a distance can record")
+{
+    nmg::OSet<int, CollidingHash, std::equal_to<int>, RobinHoodPolicy> oset;
+    OrderModel model;
+    std::uniform_int_distribution<int> pick(0, 599);
+    for(int step = 0; step < 6000; ++step)
+    {
+        int value = pick(randomVar);
+        if(step % 3 == 2)
+        {
+            REQUIRE(oset.remove(value) == model.remove(value));
+        }
+        else
+        {
+            REQUIRE(oset.add(value) == model.add(value));
+        }
+        if(step % 500 == 0)
+        {
+            REQUIRE(oset.move_to_front(value) == model.move_to_front(value));
+            REQUIRE(same_model_order(oset, model));
+        }
+    }
+    REQUIRE(same_model_order(oset, model));
+    for(int value = 0; value < 600; ++value)
+    {
+        REQUIRE(oset.contains(value) == model.contains(value));
+    }
+    // growing does not shorten runs of equal hashes, so it stops early on.
+    REQUIRE(oset.capacity() <= 8192);
+}
+
+struct IncrementalRobinHood : RobinHoodPolicy
+{
+    static constexpr size_t rehash_budget = 8;
+};
+
+TEST_CASE("OSet with a Robin Hood table matches std::set")
+{
+    PolicySet<std::string, RobinHoodPolicy> strings;
+    PolicySet<int, IncrementalRobinHood> ints;
+    OrderModel model;
+    OrderModel stringModel;
+    std::uniform_int_distribution<int> pick(0, 3000);
+
+    for(int step = 0; step < 20000; ++step)
+    {
+        int value = pick(randomVar);
+        if(step % 3 != 2)
+        {
+            REQUIRE(ints.add(value) == model.add(value));
+            REQUIRE(strings.add(std::to_string(value)) == stringModel.add(value));
+        }
+        else
+        {
+            REQUIRE(ints.remove(value) == model.remove(value));
+            REQUIRE(strings.remove(std::to_string(value)) == stringModel.remove(value));
+        }
+        if(step % 1000 == 0)
+        {
+            REQUIRE(ints.move_to_front(value) == model.move_to_front(value));
+            REQUIRE(same_model_order(ints, model));
+            REQUIRE(same_model_order(strings, stringModel));
+        }
+    }
+
+    REQUIRE(same_model_order(ints, model));
+    REQUIRE(same_model_order(strings, stringModel));
+    for(int value = 0; value <= 3000; ++value)
+    {
+        REQUIRE(ints.contains(value) == model.contains(value));
+        REQUIRE(strings.contains(std::to_string(value)) == stringModel.contains(value));
+    }
+
+    PolicySet<int, IncrementalRobinHood> copy = ints;
+    copy.shrink_to_fit();
+    REQUIRE(same_model_order(copy, model));
+    for(int value : model.order)
+    {
+        REQUIRE(copy.remove(value));
+    }
+    REQUIRE(copy.empty());
+
+    std::vector<int> items(model.order.begin(), model.order.end());
+    std::unique_ptr<bool[]> found(new bool[items.size()]);
+    REQUIRE(ints.contains_many(items, std::span<bool>(found.get(), items.size())) == items.size());
+}
+
+TEST_CASE("Reductions round to usable bucket counts and stay in range")
+{
+    REQUIRE(nmg::MaskReduction::round(0) == 1);
+    REQUIRE(nmg::MaskReduction::round(17) == 32);
+    REQUIRE(nmg::FibonacciReduction::round(64) == 64);
+    REQUIRE(nmg::PrimeReduction::round(100) == 107);
+    REQUIRE(nmg::PrimeReduction::round(127) == 127);
+
+    std::uniform_int_distribution<hash_t> pick;
+    for(size_t count : {1, 2, 64, 1024})
+    {
+        for(int i = 0; i < 1000; ++i)
+        {
+            hash_t hval = pick(randomVar);
+            REQUIRE(nmg::MaskReduction::index(hval, count) < count);
+            REQUIRE(nmg::FibonacciReduction::index(hval, count) < count);
+        }
+    }
+    for(size_t count : {2, 107, 8191})
+    {
+        REQUIRE(nmg::PrimeReduction::index(pick(randomVar), count) < count);
+    }
+}
+
+// a hash that leaves the low bits of every reduced key zero, as the
+// shifted identity of the key.
+struct WeakHash
+{
+    hash_t operator()(int key) const
+    {
+        return static_cast<hash_t>(key) << 17;
+    }
+};
+
+template <typename Reduction, template <typename, typename> typename Table> struct ReducedPolicy : nmg::DefaultPolicy
+{
+    using reduction = Reduction;
+    template <typename R, typename Index> using table_type = Table<R, Index>;
+};
+
+template <typename Policy> static void check_reduction()
+{
+    using Set = nmg::OSet<int, WeakHash, std::equal_to<int>, Policy>;
+    Set oset;
+    for(int i = 0; i < 3000; ++i)
+    {
+        REQUIRE(oset.add(i));
+    }
+    for(int i = 0; i < 3000; i += 2)
+    {
+        REQUIRE(oset.remove(i));
+    }
+    for(int i = 0; i < 3100; ++i)
+    {
+        REQUIRE(oset.contains(i) == (i < 3000 && i % 2 == 1));
+    }
+    REQUIRE(oset.capacity() == Set::Table_t::round_capacity(oset.capacity()));
+}
+
+TEST_CASE("OSet works with every reduction on both engines")
+{
+    check_reduction<ReducedPolicy<nmg::MaskReduction, nmg::IndexTable>>();
+    check_reduction<ReducedPolicy<nmg::FibonacciReduction, nmg::IndexTable>>();
+    check_reduction<ReducedPolicy<nmg::PrimeReduction, nmg::IndexTable>>();
+    check_reduction<ReducedPolicy<nmg::MaskReduction, nmg::RobinHoodTable>>();
+    check_reduction<ReducedPolicy<nmg::FibonacciReduction, nmg::RobinHoodTable>>();
+    check_reduction<ReducedPolicy<nmg::PrimeReduction, nmg::RobinHoodTable>>();
+
+    // prime tables have a prime number of groups.
+    PolicySet<int, ReducedPolicy<nmg::PrimeReduction, nmg::IndexTable>> primed;
+    primed.reserve(1000);
+    REQUIRE(primed.capacity() % nmg::Group::WIDTH == 0);
+    REQUIRE(nmg::PrimeReduction::round(primed.capacity() / nmg::Group::WIDTH) == primed.capacity() / nmg::Group::WIDTH);
+    REQUIRE(std::has_single_bit(nmg::OSet<int>(1000).capacity()));
+}
+
+struct Index16Policy : nmg::DefaultPolicy
+{
+    using index_type = uint16_t;
+};
+
+struct Index32RobinHoodPolicy : RobinHoodPolicy
+{
+    using index_type = uint32_t;
+    static constexpr size_t rehash_budget = 16;
+};
+
+TEST_CASE("OSet with narrow table indices caps its size")
+{
+    using Set16 = PolicySet<int, Index16Policy>;
+    static_assert(std::is_same_v<Set16::Table_t::index_type, uint16_t>);
+
+    Set16 oset;
+    REQUIRE(oset.max_size() == 65535);
+    REQUIRE_THROWS_AS(oset.reserve(70000), std::length_error);
+    for(int i = 0; i < 65535; ++i)
+    {
+        REQUIRE(oset.add(i));
+    }
+    REQUIRE_THROWS_AS(oset.add(-1), std::length_error);
+    REQUIRE(oset.size() == 65535);
+
+    // removed items make room again, and every position is still found.
+    for(int i = 0; i < 65535; i += 5)
+    {
+        REQUIRE(oset.remove(i));
+    }
+    for(int i = 0; i < 1000; ++i)
+    {
+        REQUIRE(oset.add(-1 - i));
+    }
+    REQUIRE(oset.move_to_front(65534));
+    for(int i = -1000; i < 65535; ++i)
+    {
+        REQUIRE(oset.contains(i) == (i < 0 || i % 5 != 0));
+    }
+    REQUIRE(oset.index_of(-1000) == oset.size() - 1);
+
+    // the order is the one the items were added and moved in.
+    std::list<int> expected = {65534};
+    for(int i = 1; i < 65534; ++i)
+    {
+        if(i % 5 != 0)
+        {
+            expected.push_back(i);
+        }
+    }
+    for(int i = 0; i < 1000; ++i)
+    {
+        expected.push_back(-1 - i);
+    }
+    REQUIRE(same_order(oset, expected));
+}
+
+TEST_CASE("OSet with 32 bit Robin Hood indices matches std::set")
+{
+    PolicySet<std::string, Index32RobinHoodPolicy> oset;
+    OrderModel model;
+    std::uniform_int_distribution<int> pick(0, 20000);
+    for(int step = 0; step < 60000; ++step)
+    {
+        int value = pick(randomVar);
+        if(step % 4 == 3)
+        {
+            REQUIRE(oset.remove(std::to_string(value)) == model.remove(value));
+        }
+        else
+        {
+            REQUIRE(oset.add(std::to_string(value)) == model.add(value));
+        }
+        if(step % 997 == 0)
+        {
+            REQUIRE(oset.move_to_front(std::to_string(value)) == model.move_to_front(value));
+        }
+    }
+    REQUIRE(same_model_order(oset, model));
+    for(int value : model.order)
+    {
+        REQUIRE(oset.contains(std::to_string(value)));
+    }
+}